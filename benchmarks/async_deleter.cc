@@ -0,0 +1,63 @@
+// -*- mode: c++; -*-
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include <unique_resource.hh>
+#include <async_deleter.hh>
+namespace X = std::experimental;
+
+using clock_type = std::chrono::steady_clock;
+
+static constexpr int N = 20 * 1000;
+
+//
+// Busy-waits, standing in for a slow close (2) or munmap (2):
+//
+static void
+spin (std::chrono::nanoseconds d) {
+    for (auto t = clock_type::now () + d; clock_type::now () < t; ) ;
+}
+
+struct slow_delete {
+    void operator() (int) const noexcept {
+        spin (std::chrono::microseconds (20));
+    }
+};
+
+template< typename D >
+static void
+run (const char* name, D d) {
+    std::vector< double > v;
+    v.reserve (N);
+
+    for (int i = 0; i < N; ++i) {
+        auto x = X::make_unique_resource (i, d);
+
+        //
+        // Request processing between two resets:
+        //
+        spin (std::chrono::microseconds (25));
+
+        auto t = clock_type::now ();
+        x.reset ();
+        v.push_back ((clock_type::now () - t).count ());
+    }
+
+    std::sort (v.begin (), v.end ());
+
+    std::cout << name << ": p50 " << v [N / 2] << " ns, p99 "
+              << v [N * 99 / 100] << " ns, max " << v.back () << " ns\n";
+}
+
+int main () {
+    run ("inline", slow_delete { });
+
+    X::reaper r;
+    run ("async_deleter", X::async_deleter< slow_delete > (slow_delete { }, r));
+    r.flush ();
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+// -*- mode: c++; -*-
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include <unique_resource.hh>
+#include <atomic_unique_resource.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 4 * 1000 * 1000;
+
+//
+// A configuration snapshot, replaced by the writer:
+//
+struct config {
+    int value [16] = { };
+};
+
+struct config_delete {
+    static constexpr config* invalid_resource = nullptr;
+
+    void operator() (config* p) const noexcept {
+        delete p;
+    }
+};
+
+using resource_type = X::unique_resource< config*, config_delete >;
+
+static resource_type make_config (int i) {
+    auto p = new config;
+    p->value [0] = i;
+    return resource_type (p, config_delete { });
+}
+
+//
+// Readers read N values in total while one writer keeps replacing the
+// published configuration:
+//
+template< typename Read, typename Write >
+static void
+run (const char* name, int readers, Read read, Write write) {
+    std::atomic< bool > done{ false };
+    std::atomic< long > writes{ 0 };
+
+    std::thread writer ([&] {
+        for (int i = 0; !done.load (std::memory_order_relaxed); ++i) {
+            write (i);
+            ++writes;
+            std::this_thread::yield ();
+        }
+    });
+
+    std::vector< std::thread > v;
+
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < readers; ++i)
+        v.emplace_back ([&] {
+            long sum = 0;
+
+            for (int j = 0; j < N / readers; ++j)
+                sum += read ();
+
+            if (sum < 0)
+                std::cout << sum;
+        });
+
+    for (auto& t : v)
+        t.join ();
+
+    timer.stop ();
+
+    done = true;
+    writer.join ();
+
+    std::cout << name << ", " << readers << " readers: "
+              << (double (timer.elapsed ().wall) / N) << " ns/read, "
+              << writes << " writes\n";
+}
+
+int main () {
+    const auto hw = (std::max) (1U, std::thread::hardware_concurrency ());
+
+    for (unsigned n = 1; n <= hw * 2; n *= 2) {
+        {
+            std::mutex m;
+            resource_type r = make_config (0);
+
+            run ("std::mutex", n, [&] {
+                std::lock_guard< std::mutex > lock (m);
+                return r.get ()->value [0];
+            }, [&](int i) {
+                auto x = make_config (i);
+                std::lock_guard< std::mutex > lock (m);
+                r = std::move (x);
+            });
+        }
+
+        {
+            std::shared_mutex m;
+            resource_type r = make_config (0);
+
+            run ("std::shared_mutex", n, [&] {
+                std::shared_lock< std::shared_mutex > lock (m);
+                return r.get ()->value [0];
+            }, [&](int i) {
+                auto x = make_config (i);
+                std::lock_guard< std::shared_mutex > lock (m);
+                r = std::move (x);
+            });
+        }
+
+        {
+            X::atomic_unique_resource< config*, config_delete > r (make_config (0));
+
+            run ("atomic_unique_resource", n, [&] {
+                return r.load ()->value [0];
+            }, [&](int i) {
+                r.store (make_config (i));
+            });
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+// -*- mode: c++; -*-
+
+//
+// Startup with a few thousand shards to open, each opening blocking on the
+// disk or the network for a while: make_unique_resources_checked, one after
+// the other and overlapped on a pool of threads.
+//
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unique_resource.hh>
+#include <unique_resource_vector.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 4000;
+
+//
+// Sleeps, standing in for an open (2) on a cold cache, or a connect (2):
+//
+static int
+open_shard (int i) noexcept {
+    std::this_thread::sleep_for (std::chrono::microseconds (100));
+    return i;
+}
+
+struct shard_delete {
+    void operator() (int) const noexcept { }
+};
+
+//
+// The simplest of thread pools:
+//
+struct thread_pool {
+    explicit thread_pool (int n) {
+        for (int i = 0; i < n; ++i)
+            threads_.emplace_back ([this] { run (); });
+    }
+
+    ~thread_pool () {
+        {
+            std::lock_guard< std::mutex > lock (mutex_);
+            stop_ = true;
+        }
+
+        cv_.notify_all ();
+
+        for (auto& t : threads_)
+            t.join ();
+    }
+
+    template< typename F >
+    void submit (F f) {
+        {
+            std::lock_guard< std::mutex > lock (mutex_);
+            tasks_.emplace_back (std::move (f));
+        }
+
+        cv_.notify_one ();
+    }
+
+private:
+    void run () {
+        for (;;) {
+            std::unique_lock< std::mutex > lock (mutex_);
+            cv_.wait (lock, [this] { return stop_ || !tasks_.empty (); });
+
+            if (tasks_.empty ())
+                return;
+
+            auto f = std::move (tasks_.front ());
+            tasks_.pop_front ();
+
+            lock.unlock ();
+            f ();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque< std::function< void () > > tasks_;
+    bool stop_ = false;
+
+    std::vector< std::thread > threads_;
+};
+
+template< typename F >
+static void
+run (const char* name, F f) {
+    bt::cpu_timer timer;
+    const auto n = f ();
+    timer.stop ();
+
+    std::cout << name << ": " << (timer.elapsed ().wall / 1e6) << " ms for "
+              << n << " shards\n";
+}
+
+int main () {
+    std::vector< int > shards (N);
+    std::iota (shards.begin (), shards.end (), 0);
+
+    run ("sequential", [&] {
+        return X::make_unique_resources_checked (
+            shards, &open_shard, -1, shard_delete { }).size ();
+    });
+
+    for (int n : { 4, 16, 64 }) {
+        thread_pool pool (n);
+
+        const std::string name = "on " + std::to_string (n) + " threads";
+
+        run (name.c_str (), [&] {
+            return X::make_unique_resources_checked (
+                pool, shards, &open_shard, -1, shard_delete { }).size ();
+        });
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+// -*- mode: c++; -*-
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <unique_resource.hh>
+#include <unique_resource_vector.hh>
+#include <fd_delete.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int M = 20;
+
+//
+// Descriptors are dup'ed from /dev/null, up to the soft limit:
+//
+static int
+max_fds () {
+    rlimit r;
+    ::getrlimit (RLIMIT_NOFILE, &r);
+
+    r.rlim_cur = r.rlim_max;
+    ::setrlimit (RLIMIT_NOFILE, &r);
+
+    ::getrlimit (RLIMIT_NOFILE, &r);
+    return int ((std::min) (rlim_t (50000), r.rlim_cur - 64));
+}
+
+template< typename T, typename F, typename G >
+static void
+run (const char* name, int n, F acquire, G teardown) {
+    double total = 0;
+
+    const int fd = ::open ("/dev/null", O_RDONLY);
+
+    for (int j = 0; j < M; ++j) {
+        T t;
+
+        for (int i = 0; i < n; ++i)
+            acquire (t, ::dup (fd));
+
+        bt::cpu_timer timer;
+        teardown (t);
+        timer.stop ();
+
+        total += timer.elapsed ().wall;
+    }
+
+    ::close (fd);
+
+    std::cout << name << ": " << (total / M / 1e6) << " ms for " << n
+              << " descriptors\n";
+}
+
+int main () {
+    const int n = max_fds ();
+
+    using T = X::unique_fd;
+
+    auto emplace = [](auto& v, int fd) {
+        v.emplace_back (fd, X::fd_delete { });
+    };
+
+    run< std::vector< T > > (
+        "std::vector< unique_fd >, reset ()", n, emplace,
+        [](auto& v) { for (auto& x : v) x.reset (); });
+
+    run< std::vector< T > > (
+        "std::vector< unique_fd >, reset_all ()", n, emplace,
+        [](auto& v) { X::reset_all (v.begin (), v.end ()); });
+
+    run< X::unique_resource_vector< int, X::fd_delete > > (
+        "unique_resource_vector< int, fd_delete >", n,
+        [](auto& v, int fd) { v.push_back (fd); },
+        [](auto& v) { v.reset_all (); });
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+// -*- mode: c++; -*-
+
+#include <iostream>
+
+#include <unique_resource.hh>
+#include <defer_stack.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 10 * 1000 * 1000;
+
+static volatile int sink;
+
+//
+// Eight conditional cleanups, each with a few words of state. With scope
+// guards, every guard is declared up front and the unneeded ones released:
+//
+#define GUARD(i)                                                 \
+    auto g##i = make ([a, b, c] { sink = sink + a + b + c; });   \
+    if (0 == (mask & (1 << i)))                                  \
+        g##i.release ()
+
+template< typename Make >
+__attribute__ ((noinline)) static void
+guards (unsigned mask, int a, int b, int c, Make make) {
+    GUARD (0); GUARD (1); GUARD (2); GUARD (3);
+    GUARD (4); GUARD (5); GUARD (6); GUARD (7);
+}
+
+#undef GUARD
+
+#define DEFER(i)                                                 \
+    if (mask & (1 << i))                                         \
+        d.defer ([a, b, c] { sink = sink + a + b + c; })
+
+template< typename T >
+__attribute__ ((noinline)) static void
+defers (unsigned mask, int a, int b, int c) {
+    T d;
+
+    DEFER (0); DEFER (1); DEFER (2); DEFER (3);
+    DEFER (4); DEFER (5); DEFER (6); DEFER (7);
+}
+
+#undef DEFER
+
+template< typename F >
+static void
+run (const char* name, F f) {
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < N; ++i)
+        f (unsigned (i) * 37U, i, i + 1, i + 2);
+
+    timer.stop ();
+
+    std::cout << name << ": " << (double (timer.elapsed ().wall) / N)
+              << " ns/call\n";
+}
+
+int main () {
+    auto exit = [](auto f) { return X::make_scope_exit (std::move (f)); };
+    auto fail = [](auto f) { return X::make_scope_fail (std::move (f)); };
+
+    run ("scope_exit chain", [&](unsigned m, int a, int b, int c) {
+        guards (m, a, b, c, exit);
+    });
+
+    run ("defer_exit_stack", [](unsigned m, int a, int b, int c) {
+        defers< X::defer_exit_stack< > > (m, a, b, c);
+    });
+
+    run ("scope_fail chain", [&](unsigned m, int a, int b, int c) {
+        guards (m, a, b, c, fail);
+    });
+
+    run ("defer_fail_stack", [](unsigned m, int a, int b, int c) {
+        defers< X::defer_fail_stack< > > (m, a, b, c);
+    });
+
+    return 0;
+}
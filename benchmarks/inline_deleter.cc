@@ -0,0 +1,61 @@
+// -*- mode: c++; -*-
+
+#include <functional>
+#include <iostream>
+
+#include <unique_resource.hh>
+#include <inline_deleter.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 50 * 1000 * 1000;
+
+static int counter /* = 0 */;
+
+static void f (int i) {
+    counter += i;
+}
+
+template< typename D, typename F >
+static void
+run (const char* name, F f) {
+    counter = 0;
+
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < N; ++i) {
+        auto x = X::unique_resource< int, D > (i & 1, D (f));
+        x.reset ();
+    }
+
+    timer.stop ();
+
+    std::cout << name << ": " << (double (timer.elapsed ().wall) / N)
+              << " ns/op (" << counter << ")\n";
+}
+
+int main () {
+    int delta = 1;
+
+    run< void(*)(int) > ("function pointer", f);
+    run< std::function< void(int) > > ("std::function", f);
+    run< X::inline_deleter< void(int) > > ("inline_deleter", f);
+
+    auto g = [&](int i) { counter += i * delta; };
+
+    run< std::function< void(int) > > ("std::function (lambda)", g);
+    run< X::inline_deleter< void(int) > > ("inline_deleter (lambda)", g);
+
+    //
+    // Past the std::function small-buffer capacity:
+    //
+    int a = 1, b = 1, c = 1;
+    auto h = [&](int i) { counter += i * a * b * c; };
+
+    run< std::function< void(int) > > ("std::function (large lambda)", h);
+    run< X::inline_deleter< void(int), sizeof h > > ("inline_deleter (large lambda)", h);
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+// -*- mode: c++; -*-
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unique_resource.hh>
+#include <rcu_resource.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 4 * 1000 * 1000;
+
+//
+// A routing table, replaced by the writer:
+//
+struct table {
+    int routes [256] = { };
+};
+
+struct table_delete {
+    void operator() (table* p) const noexcept {
+        delete p;
+    }
+};
+
+using resource_type = X::unique_resource< table*, table_delete >;
+
+static resource_type make_table (int i) {
+    auto p = new table;
+    p->routes [i % 256] = i;
+    return resource_type (p, table_delete { });
+}
+
+//
+// Readers do N lookups in total while one writer keeps replacing the
+// table:
+//
+template< typename Read, typename Write >
+static void
+run (const char* name, int readers, Read read, Write write) {
+    std::atomic< bool > done{ false };
+    std::atomic< long > writes{ 0 };
+
+    std::thread writer ([&] {
+        for (int i = 0; !done.load (std::memory_order_relaxed); ++i) {
+            write (i);
+            ++writes;
+            std::this_thread::yield ();
+        }
+    });
+
+    std::vector< std::thread > v;
+
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < readers; ++i)
+        v.emplace_back ([&, i] {
+            long sum = 0;
+
+            for (int j = 0; j < N / readers; ++j)
+                sum += read (i + j);
+
+            if (sum < 0)
+                std::cout << sum;
+        });
+
+    for (auto& t : v)
+        t.join ();
+
+    timer.stop ();
+
+    done = true;
+    writer.join ();
+
+    std::cout << name << ", " << readers << " readers: "
+              << (double (timer.elapsed ().wall) / N) << " ns/read, "
+              << writes << " writes\n";
+}
+
+int main () {
+    const auto hw = (std::max) (1U, std::thread::hardware_concurrency ());
+
+    //
+    // 1, 2, 4, ... and all cores:
+    //
+    for (unsigned n = 1; ; n = (std::min) (2 * n, hw)) {
+        {
+            std::mutex m;
+            resource_type r = make_table (0);
+
+            run ("std::mutex", n, [&](int i) {
+                std::lock_guard< std::mutex > lock (m);
+                return r.get ()->routes [i % 256];
+            }, [&](int i) {
+                auto x = make_table (i);
+                std::lock_guard< std::mutex > lock (m);
+                r = std::move (x);
+            });
+        }
+
+        {
+            auto r = std::make_shared< resource_type > (make_table (0));
+
+            run ("std::shared_ptr", n, [&](int i) {
+                auto p = std::atomic_load (&r);
+                return p->get ()->routes [i % 256];
+            }, [&](int i) {
+                std::atomic_store (
+                    &r, std::make_shared< resource_type > (make_table (i)));
+            });
+        }
+
+        {
+            X::rcu_resource< table*, table_delete > r (make_table (0));
+
+            run ("rcu_resource", n, [&](int i) {
+                X::rcu_read_guard guard;
+                return r.read (guard)->routes [i % 256];
+            }, [&](int i) {
+                r.store (make_table (i));
+            });
+        }
+
+        if (n == hw)
+            break;
+    }
+
+    return 0;
+}
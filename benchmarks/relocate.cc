@@ -0,0 +1,64 @@
+// -*- mode: c++; -*-
+
+#include <iostream>
+#include <vector>
+
+#include <unique_resource.hh>
+#include <relocate.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 10 * 1000 * 1000;
+
+static long counter /* = 0 */;
+
+struct fd_delete {
+    void operator() (int fd) const noexcept {
+        counter += fd;
+    }
+};
+
+struct checked_fd_delete : fd_delete {
+    static constexpr int invalid_resource = -1;
+};
+
+template< typename C, typename D >
+static void
+run (const char* name) {
+    counter = 0;
+
+    bt::cpu_timer timer;
+
+    {
+        C c;
+
+        for (int i = 0; i < N; ++i)
+            c.emplace_back (i, D { });
+
+        timer.stop ();
+    }
+
+    std::cout << name << ": " << (double (timer.elapsed ().wall) / 1e6)
+              << " ms (" << counter << ")\n";
+}
+
+template< typename D >
+using vector = std::vector< X::unique_resource< int, D > >;
+
+template< typename D >
+using relocating_vector = X::relocating_vector< X::unique_resource< int, D > >;
+
+int main () {
+    run< vector< fd_delete >, fd_delete > ("std::vector");
+    run< relocating_vector< fd_delete >, fd_delete > ("relocating_vector");
+
+    run< vector< checked_fd_delete >, checked_fd_delete > (
+        "std::vector (sentinel)");
+
+    run< relocating_vector< checked_fd_delete >, checked_fd_delete > (
+        "relocating_vector (sentinel)");
+
+    return 0;
+}
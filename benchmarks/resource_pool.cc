@@ -0,0 +1,72 @@
+// -*- mode: c++; -*-
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <unique_resource.hh>
+#include <resource_pool.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 1000 * 1000;
+
+//
+// A 4 KiB zeroed buffer stands in for a connection or a parser:
+//
+struct factory {
+    char* operator() () const {
+        return new char [4096] ();
+    }
+};
+
+struct deleter {
+    void operator() (char* p) const noexcept {
+        delete [] p;
+    }
+};
+
+template< typename F >
+static void
+run (const char* name, int threads, F f) {
+    std::vector< std::thread > v;
+
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < threads; ++i)
+        v.emplace_back ([&] {
+            for (int j = 0; j < N / threads; ++j)
+                f ();
+        });
+
+    for (auto& t : v)
+        t.join ();
+
+    timer.stop ();
+
+    std::cout << name << ", " << threads << " threads: "
+              << (N / (double (timer.elapsed ().wall) / 1e9)) << " ops/s\n";
+}
+
+int main () {
+    using pool_type = X::resource_pool< char*, factory, deleter >;
+
+    for (int n = 1; n <= 64; n *= 2) {
+        run ("create/destroy", n, [] {
+            auto x = X::make_unique_resource (factory { }(), deleter { });
+            x.get () [0] = 1;
+        });
+
+        pool_type pool;
+
+        run ("resource_pool", n, [&] {
+            auto x = pool.acquire ();
+            x.get () [0] = 1;
+        });
+    }
+
+    return 0;
+}
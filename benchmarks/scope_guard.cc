@@ -0,0 +1,78 @@
+// -*- mode: c++; -*-
+
+#include <iostream>
+
+#include <unique_resource.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 1000 * 1000;
+static constexpr int M = 16;
+
+static volatile int sink;
+
+//
+// A request that makes M undo guards, one per step, and succeeds:
+//
+template< typename F >
+__attribute__ ((noinline)) static void
+request (F make) {
+    for (int i = 0; i < M; ++i) {
+        auto g = make ([i] { sink = i; });
+        sink = sink + 1;
+    }
+}
+
+template< typename F >
+static void
+run (const char* name, F f) {
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < N; ++i)
+        f ();
+
+    timer.stop ();
+
+    std::cout << name << ": " << (double (timer.elapsed ().wall) / N / M)
+              << " ns/guard\n";
+}
+
+int main () {
+    run ("make_scope_fail", [] {
+        request ([](auto f) { return X::make_scope_fail (std::move (f)); });
+    });
+
+    run ("make_scope_fail (transaction_scope)", [] {
+        X::transaction_scope t;
+        request ([&](auto f) { return X::make_scope_fail (t, std::move (f)); });
+    });
+
+    //
+    // Committed before the guards, each destroyed at the end of its step,
+    // check the transaction:
+    //
+    run ("make_scope_fail (transaction)", [] {
+        X::transaction t;
+        t.commit ();
+        request ([&](auto f) { return X::make_scope_fail (t, std::move (f)); });
+    });
+
+    run ("make_scope_success", [] {
+        request ([](auto f) { return X::make_scope_success (std::move (f)); });
+    });
+
+    run ("make_scope_success (transaction_scope)", [] {
+        X::transaction_scope t;
+        request ([&](auto f) { return X::make_scope_success (t, std::move (f)); });
+    });
+
+    run ("make_scope_success (transaction)", [] {
+        X::transaction t;
+        t.commit ();
+        request ([&](auto f) { return X::make_scope_success (t, std::move (f)); });
+    });
+
+    return 0;
+}
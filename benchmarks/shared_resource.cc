@@ -0,0 +1,106 @@
+// -*- mode: c++; -*-
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <unique_resource.hh>
+#include <shared_resource.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 4 * 1000 * 1000;
+
+struct fd_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int) const noexcept { }
+};
+
+//
+// Every thread copies and destroys its own copy of one shared handle:
+//
+template< typename T >
+static void
+contention (const char* name, int threads, const T& x) {
+    std::vector< std::thread > v;
+
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < threads; ++i)
+        v.emplace_back ([y = x, threads] {
+            for (int j = 0; j < N / threads; ++j)
+                T z (y);
+        });
+
+    for (auto& t : v)
+        t.join ();
+
+    timer.stop ();
+
+    std::cout << name << ", " << threads << " threads: "
+              << (double (timer.elapsed ().wall) / N) << " ns/copy\n";
+}
+
+template< typename F >
+static void
+creation (const char* name, F f) {
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < N; ++i)
+        f (i);
+
+    timer.stop ();
+
+    std::cout << name << ": " << (double (timer.elapsed ().wall) / N)
+              << " ns/create\n";
+}
+
+int main () {
+    using U = X::unique_resource< int, fd_delete >;
+
+    creation ("shared_ptr< unique_resource >", [](int i) {
+        std::shared_ptr< U > (new U (i, fd_delete { }));
+    });
+
+    creation ("shared_resource", [](int i) {
+        X::make_shared_resource (i, fd_delete { });
+    });
+
+    const auto hw = (std::max) (1U, std::thread::hardware_concurrency ());
+
+    for (unsigned n = 1; n <= hw * 2; n *= 2) {
+        contention ("shared_ptr< unique_resource >", n,
+                    std::shared_ptr< U > (new U (1, fd_delete { })));
+
+        contention ("shared_resource< atomic_refcount >", n,
+                    X::make_shared_resource (1, fd_delete { }));
+
+        contention ("shared_resource< biased_refcount >", n,
+                    X::make_shared_resource< X::biased_refcount > (
+                        1, fd_delete { }));
+    }
+
+    //
+    // The owner thread alone, where biasing pays off:
+    //
+    {
+        auto x = X::make_shared_resource< X::biased_refcount > (1, fd_delete { });
+
+        bt::cpu_timer timer;
+
+        for (int j = 0; j < N; ++j)
+            auto y (x);
+
+        timer.stop ();
+
+        std::cout << "shared_resource< biased_refcount >, owner thread: "
+                  << (double (timer.elapsed ().wall) / N) << " ns/copy\n";
+    }
+
+    return 0;
+}
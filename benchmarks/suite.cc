@@ -0,0 +1,426 @@
+// -*- mode: c++; -*-
+
+//
+// The basic operations of unique_resource and the scope guards, next to the
+// same operations on a raw handle and on a std::unique_ptr with a handle
+// deleter, for each kind of deleter. Prints JSON; every case runs a fixed
+// number of iterations, repeated, and reports the median and the minimum.
+//
+// Usage: suite [SUBSTRING], to run only the cases whose name contains it.
+//
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unique_resource.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 2 * 1000 * 1000;
+static constexpr int REPETITIONS = 5;
+
+static volatile int sink;
+
+__attribute__ ((noinline)) static void close_handle (int h) noexcept {
+    sink = sink + h;
+}
+
+__attribute__ ((noinline)) static void undo () noexcept {
+    sink = sink + 1;
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// The deleter kinds, each making a deleter for the handles and a callable
+// for the scope guards:
+//
+struct function_pointer_kind {
+    static constexpr const char* name = "function pointer";
+
+    static auto deleter () noexcept {
+        return &close_handle;
+    }
+
+    static auto callback () noexcept {
+        return &undo;
+    }
+};
+
+struct lambda_kind {
+    static constexpr const char* name = "lambda";
+
+    static auto deleter () noexcept {
+        return [](int h) noexcept { close_handle (h); };
+    }
+
+    static auto callback () noexcept {
+        return [] () noexcept { undo (); };
+    }
+};
+
+struct function_kind {
+    static constexpr const char* name = "std::function";
+
+    static auto deleter () {
+        return std::function< void(int) > (&close_handle);
+    }
+
+    static auto callback () {
+        return std::function< void() > (&undo);
+    }
+};
+
+//
+// A handle that std::unique_ptr can hold, -1 being null:
+//
+struct handle {
+    handle () noexcept = default;
+    handle (std::nullptr_t) noexcept { }
+    handle (int h) noexcept : value (h) { }
+
+    explicit operator bool () const noexcept {
+        return -1 != value;
+    }
+
+    friend bool operator== (handle a, handle b) noexcept {
+        return a.value == b.value;
+    }
+
+    friend bool operator!= (handle a, handle b) noexcept {
+        return a.value != b.value;
+    }
+
+    int value = -1;
+};
+
+template< typename D >
+struct handle_deleter {
+    using pointer = handle;
+
+    void operator() (handle h) const {
+        d (h.value);
+    }
+
+    D d;
+};
+
+template< typename K >
+using deleter_t = decltype (K::deleter ());
+
+//
+// Captureless lambdas are not assignable before C++20, nor are the handles
+// that hold them:
+//
+template< typename K >
+constexpr bool is_assignable_v = std::is_move_assignable_v< deleter_t< K > >;
+
+template< typename K >
+using unique_ptr_t = std::unique_ptr< handle, handle_deleter< deleter_t< K > > >;
+
+template< typename K >
+static auto make_unique_ptr (int h) {
+    return unique_ptr_t< K > (
+        h, handle_deleter< deleter_t< K > > { K::deleter () });
+}
+
+//
+// A raw handle, released by hand:
+//
+template< typename K >
+struct raw_handle {
+    explicit raw_handle (int x, bool b = true)
+        : h (x), owns (b), d (K::deleter ())
+        { }
+
+    raw_handle (const raw_handle&) = delete;
+    raw_handle& operator= (const raw_handle&) = delete;
+
+    int h;
+    bool owns;
+    deleter_t< K > d;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+struct result {
+    std::string benchmark, subject, deleter;
+    double median, min;
+};
+
+static std::vector< result > results;
+static const char* filter;
+
+template< typename F >
+static void
+run (const char* benchmark, const char* subject, const char* deleter, F f) {
+    const std::string name =
+        std::string (benchmark) + "/" + subject + "/" + deleter;
+
+    if (filter && std::string::npos == name.find (filter))
+        return;
+
+    std::vector< double > v;
+
+    for (int r = 0; r < REPETITIONS; ++r) {
+        bt::cpu_timer timer;
+
+        for (int i = 0; i < N; ++i)
+            f (i);
+
+        timer.stop ();
+
+        v.push_back (double (timer.elapsed ().wall) / N);
+    }
+
+    std::sort (v.begin (), v.end ());
+
+    results.push_back ({ benchmark, subject, deleter, v [v.size () / 2], v [0] });
+}
+
+//
+// Half of the checked handles are invalid:
+//
+static int checked (int i) noexcept {
+    return i & 1 ? i : -1;
+}
+
+template< typename K >
+static void run_raw () {
+    const char* s = "raw handle";
+
+    run ("make", s, K::name, [](int i) {
+        raw_handle< K > x (i);
+
+        if (x.owns)
+            x.d (x.h);
+    });
+
+    run ("make_checked", s, K::name, [](int i) {
+        const int h = checked (i);
+        raw_handle< K > x (h, -1 != h);
+
+        if (x.owns)
+            x.d (x.h);
+    });
+
+    run ("reset", s, K::name, [](int i) {
+        raw_handle< K > x (i);
+
+        if (x.owns) {
+            x.owns = false;
+            x.d (x.h);
+        }
+
+        if (x.owns)
+            x.d (x.h);
+    });
+
+    run ("release", s, K::name, [](int i) {
+        raw_handle< K > x (i);
+
+        x.owns = false;
+        sink = x.h;
+
+        if (x.owns)
+            x.d (x.h);
+    });
+
+    run ("move_construct", s, K::name, [](int i) {
+        raw_handle< K > x (i);
+        raw_handle< K > y (x.h, x.owns);
+
+        x.owns = false;
+
+        if (y.owns)
+            y.d (y.h);
+
+        if (x.owns)
+            x.d (x.h);
+    });
+
+    if constexpr (is_assignable_v< K >) {
+        run ("move_assign", s, K::name, [](int i) {
+            raw_handle< K > x (i), y (i + 1);
+
+            if (x.owns)
+                x.d (x.h);
+
+            x.h = y.h;
+            x.d = std::move (y.d);
+            x.owns = std::exchange (y.owns, false);
+
+            if (y.owns)
+                y.d (y.h);
+
+            if (x.owns)
+                x.d (x.h);
+        });
+    }
+}
+
+template< typename K >
+static void run_unique_ptr () {
+    const char* s = "std::unique_ptr";
+
+    run ("make", s, K::name, [](int i) {
+        auto x = make_unique_ptr< K > (i);
+    });
+
+    run ("make_checked", s, K::name, [](int i) {
+        auto x = make_unique_ptr< K > (checked (i));
+    });
+
+    run ("reset", s, K::name, [](int i) {
+        auto x = make_unique_ptr< K > (i);
+        x.reset ();
+    });
+
+    run ("release", s, K::name, [](int i) {
+        auto x = make_unique_ptr< K > (i);
+        sink = x.release ().value;
+    });
+
+    run ("move_construct", s, K::name, [](int i) {
+        auto x = make_unique_ptr< K > (i);
+        auto y = std::move (x);
+    });
+
+    if constexpr (is_assignable_v< K >) {
+        run ("move_assign", s, K::name, [](int i) {
+            auto x = make_unique_ptr< K > (i);
+            auto y = make_unique_ptr< K > (i + 1);
+
+            x = std::move (y);
+        });
+    }
+}
+
+template< typename K >
+static void run_unique_resource () {
+    const char* s = "unique_resource";
+
+    run ("make", s, K::name, [](int i) {
+        auto x = X::make_unique_resource (int (i), K::deleter ());
+    });
+
+    run ("make_checked", s, K::name, [](int i) {
+        auto x = X::make_unique_resource_checked (checked (i), -1, K::deleter ());
+    });
+
+    run ("reset", s, K::name, [](int i) {
+        auto x = X::make_unique_resource (int (i), K::deleter ());
+        x.reset ();
+    });
+
+    run ("release", s, K::name, [](int i) {
+        auto x = X::make_unique_resource (int (i), K::deleter ());
+        sink = x.release ();
+    });
+
+    run ("move_construct", s, K::name, [](int i) {
+        auto x = X::make_unique_resource (int (i), K::deleter ());
+        auto y = std::move (x);
+    });
+
+    if constexpr (is_assignable_v< K >) {
+        run ("move_assign", s, K::name, [](int i) {
+            auto x = X::make_unique_resource (int (i), K::deleter ());
+            auto y = X::make_unique_resource (i + 1, K::deleter ());
+
+            x = std::move (y);
+        });
+    }
+}
+
+//
+// Without an exception, the raw equivalent of scope_exit and scope_success
+// is the call itself, and of scope_fail nothing but making the callable:
+//
+template< typename K >
+static void run_scope_guards () {
+    run ("scope_exit", "raw handle", K::name, [](int) {
+        auto f = K::callback ();
+        f ();
+    });
+
+    run ("scope_exit", "scope_guard", K::name, [](int) {
+        auto g = X::make_scope_exit (K::callback ());
+    });
+
+    run ("scope_fail", "raw handle", K::name, [](int) {
+        auto f = K::callback ();
+        (void) f;
+    });
+
+    run ("scope_fail", "scope_guard", K::name, [](int) {
+        auto g = X::make_scope_fail (K::callback ());
+    });
+
+    run ("scope_success", "raw handle", K::name, [](int) {
+        auto f = K::callback ();
+        f ();
+    });
+
+    run ("scope_success", "scope_guard", K::name, [](int) {
+        auto g = X::make_scope_success (K::callback ());
+    });
+}
+
+template< typename K >
+static void run_all () {
+    run_raw< K > ();
+    run_unique_ptr< K > ();
+    run_unique_resource< K > ();
+    run_scope_guards< K > ();
+}
+
+//
+// One result per line, so that two runs diff line by line:
+//
+static void print_json (std::ostream& s) {
+    s << "{\n"
+      << "  \"context\": {\n"
+      << "    \"compiler\": \"" << __VERSION__ << "\",\n"
+      << "    \"iterations\": " << N << ",\n"
+      << "    \"repetitions\": " << REPETITIONS << ",\n"
+      << "    \"unit\": \"ns/op\"\n"
+      << "  },\n"
+      << "  \"benchmarks\": [\n";
+
+    for (std::size_t i = 0; i < results.size (); ++i) {
+        const auto& x = results [i];
+
+        s << "    { \"benchmark\": \"" << x.benchmark
+          << "\", \"subject\": \"" << x.subject
+          << "\", \"deleter\": \"" << x.deleter
+          << "\", \"median\": " << x.median
+          << ", \"min\": " << x.min
+          << " }" << (i + 1 < results.size () ? "," : "") << "\n";
+    }
+
+    s << "  ]\n"
+      << "}\n";
+}
+
+int main (int argc, char** argv) {
+    if (argc > 1)
+        filter = argv [1];
+
+    run_all< function_pointer_kind > ();
+    run_all< lambda_kind > ();
+    run_all< function_kind > ();
+
+    print_json (std::cout);
+
+    return 0;
+}
@@ -0,0 +1,86 @@
+// -*- mode: c++; -*-
+
+//
+// Shutdown with a million live resources, heap blocks here, destroyed with
+// their deleters and after begin_process_teardown (); then the cost of the
+// teardown check in the destructor, with and without a skippable deleter.
+//
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <unique_resource.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 1000 * 1000;
+static constexpr int M = 100 * 1000 * 1000;
+
+static volatile int sink;
+
+struct free_delete {
+    static constexpr bool skip_at_teardown = true;
+    static constexpr void* invalid_resource = nullptr;
+
+    void operator() (void* p) const noexcept {
+        std::free (p);
+    }
+};
+
+template< bool B >
+struct int_delete {
+    static constexpr bool skip_at_teardown = B;
+
+    __attribute__ ((noinline))
+    void operator() (int i) const noexcept {
+        sink = sink + i;
+    }
+};
+
+using block = X::unique_resource< void*, free_delete >;
+
+static void
+shutdown (const char* name, bool teardown) {
+    auto v = new std::vector< block >;
+    v->reserve (N);
+
+    for (int i = 0; i < N; ++i)
+        v->emplace_back (std::malloc (64), free_delete { });
+
+    if (teardown)
+        X::begin_process_teardown ();
+
+    bt::cpu_timer timer;
+    delete v;
+    timer.stop ();
+
+    std::cout << name << ": " << (timer.elapsed ().wall / 1e6) << " ms for "
+              << N << " resources\n";
+}
+
+template< bool B >
+static void
+destroy (const char* name) {
+    bt::cpu_timer timer;
+
+    for (int i = 0; i < M; ++i)
+        auto x = X::make_unique_resource (int (i), int_delete< B > { });
+
+    timer.stop ();
+
+    std::cout << name << ": " << (double (timer.elapsed ().wall) / M)
+              << " ns per make and destroy\n";
+}
+
+int main () {
+    destroy< false > ("not skippable");
+    destroy< true > ("skippable, before teardown");
+
+    shutdown ("with deleters", false);
+    shutdown ("after begin_process_teardown ()", true);
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+// -*- mode: c++; -*-
+
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <poll.h>
+
+#include <unique_resource.hh>
+#include <unique_resource_vector.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 10 * 1000;
+static constexpr int M = 1000;
+
+static long counter /* = 0 */;
+
+static void f (int fd) {
+    counter += fd;
+}
+
+template< typename T >
+static void
+build_poll_set (const T& t, std::vector< pollfd >& fds) {
+    fds.clear ();
+
+    for (const auto& x : t)
+        fds.push_back ({ int (x), POLLIN, 0 });
+}
+
+int main () {
+    using D = std::function< void(int) >;
+
+    std::vector< pollfd > fds;
+    fds.reserve (N);
+
+    {
+        counter = 0;
+
+        bt::cpu_timer timer;
+
+        for (int j = 0; j < M; ++j) {
+            std::vector< X::unique_resource< int, D > > v;
+            v.reserve (N);
+
+            for (int i = 0; i < N; ++i)
+                v.emplace_back (i, D (f));
+
+            build_poll_set (v, fds);
+        }
+
+        timer.stop ();
+
+        std::cout << "std::vector< unique_resource >: "
+                  << (double (timer.elapsed ().wall) / N / M)
+                  << " ns/element (" << counter << ")\n";
+    }
+
+    {
+        counter = 0;
+
+        bt::cpu_timer timer;
+
+        for (int j = 0; j < M; ++j) {
+            X::unique_resource_vector< int, D > v { D (f) };
+            v.reserve (N);
+
+            for (int i = 0; i < N; ++i)
+                v.push_back (i);
+
+            build_poll_set (v, fds);
+        }
+
+        timer.stop ();
+
+        std::cout << "unique_resource_vector: "
+                  << (double (timer.elapsed ().wall) / N / M)
+                  << " ns/element (" << counter << ")\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+// -*- mode: c++; -*-
+
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <unique_resource.hh>
+#include <fd_delete.hh>
+#include <uring_delete.hh>
+namespace X = std::experimental;
+
+#include <boost/timer/timer.hpp>
+namespace bt = boost::timer;
+
+static constexpr int N = 1000;
+static constexpr int M = 200;
+
+template< typename D, typename F >
+static void
+run (const char* name, F flush) {
+    const int fd = ::open ("/dev/null", O_RDONLY);
+
+    double total = 0;
+
+    for (int j = 0; j < M; ++j) {
+        int fds [N];
+
+        for (auto& x : fds)
+            x = ::dup (fd);
+
+        bt::cpu_timer timer;
+
+        for (auto x : fds)
+            X::unique_resource< int, D > (x, D { });
+
+        flush ();
+
+        timer.stop ();
+        total += timer.elapsed ().wall;
+    }
+
+    ::close (fd);
+
+    std::cout << name << ": " << (total / N / M) << " ns/close\n";
+}
+
+int main () {
+    run< X::fd_delete > ("close (2)", [] { });
+
+    if (!X::uring_closer::instance ().available ())
+        std::cout << "io_uring unavailable, falling back to close (2)\n";
+
+    run< X::uring_fd_delete > ("IORING_OP_CLOSE", [] {
+        X::uring_closer::instance ().flush ();
+    });
+
+    return 0;
+}
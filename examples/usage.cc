@@ -19,5 +19,13 @@ int main () {
         T t = X::make_unique_resource_checked (0, 0, f);
     }
 
+    {
+        X::static_unique_resource< int, &f > t = X::make_unique_resource< &f > (0);
+    }
+
+    {
+        auto t = X::make_unique_resource_checked< &f > (0, -1);
+    }
+
     return 0;
 }
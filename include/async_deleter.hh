@@ -0,0 +1,295 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_ASYNC_DELETER_HPP
+#define STD_ASYNC_DELETER_HPP
+
+#include <unique_resource.hh>
+#include <inline_deleter.hh>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace std {
+namespace experimental {
+
+//
+// What reaper::submit does when the queue is full:
+//
+enum class reaper_overflow {
+    block,        // wait for the reaper thread to make room
+    inline_delete // run the deleter on the calling thread
+};
+
+//
+// A dedicated thread that runs deleters handed over by other threads. The
+// queue is a bounded, lock-free multi-producer ring (after D. Vyukov); the
+// reaper thread only sleeps on a condition variable when the ring is empty.
+//
+struct reaper {
+    using task_type = inline_deleter< void (), 6 * sizeof (void*) >;
+
+private:
+    struct slot {
+        std::atomic< std::size_t > seq;
+        task_type task;
+    };
+
+public:
+    explicit reaper (
+        std::size_t capacity = 4096,
+        reaper_overflow policy = reaper_overflow::block)
+        : mask_ (round_up (capacity) - 1),
+          slots_ (new slot [mask_ + 1]),
+          policy_ (policy) {
+        for (std::size_t i = 0; i <= mask_; ++i)
+            slots_ [i].seq.store (i, std::memory_order_relaxed);
+
+        thread_ = std::thread ([this] { run (); });
+    }
+
+    reaper (const reaper&) = delete;
+    reaper& operator= (const reaper&) = delete;
+
+    //
+    // Runs all pending deleters before returning:
+    //
+    ~reaper () {
+        {
+            std::lock_guard< std::mutex > lock (mutex_);
+            stop_ = true;
+            sleeping_.store (false, std::memory_order_relaxed);
+        }
+
+        cv_.notify_one ();
+        thread_.join ();
+    }
+
+    template< typename F >
+    void submit (F&& f) noexcept {
+        task_type task (std::forward< F > (f));
+
+        while (!try_push (task)) {
+            if (reaper_overflow::inline_delete == policy_) {
+                task ();
+                return;
+            }
+
+            wake ();
+            std::this_thread::yield ();
+        }
+
+        wake ();
+    }
+
+    //
+    // Waits until every deleter submitted before the call has run. Must not
+    // be called from a deleter running on the reaper thread:
+    //
+    void flush () noexcept {
+        //
+        // Tasks complete in queue order, the claimed positions are a bound:
+        //
+        const auto target = enqueue_pos_.load ();
+
+        if (completed_.load () >= target)
+            return;
+
+        waiters_.fetch_add (1);
+
+        {
+            std::unique_lock< std::mutex > lock (mutex_);
+            done_.wait (lock, [&] { return completed_.load () >= target; });
+        }
+
+        waiters_.fetch_sub (1);
+    }
+
+    std::size_t capacity () const noexcept {
+        return mask_ + 1;
+    }
+
+    static reaper& instance () {
+        static reaper r;
+        return r;
+    }
+
+private:
+    static std::size_t round_up (std::size_t n) noexcept {
+        std::size_t x = 2;
+        for (; x < n; x <<= 1) ;
+        return x;
+    }
+
+    bool try_push (task_type& task) noexcept {
+        auto pos = enqueue_pos_.load (std::memory_order_relaxed);
+
+        for (slot* p; ; ) {
+            p = &slots_ [pos & mask_];
+
+            const auto seq = p->seq.load (std::memory_order_acquire);
+            const auto diff = std::intptr_t (seq) - std::intptr_t (pos);
+
+            if (0 == diff) {
+                if (enqueue_pos_.compare_exchange_weak (
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    p->task = std::move (task);
+                    p->seq.store (pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = enqueue_pos_.load (std::memory_order_relaxed);
+        }
+    }
+
+    bool try_pop (task_type& task) noexcept {
+        slot& s = slots_ [dequeue_pos_ & mask_];
+
+        if (s.seq.load (std::memory_order_acquire) != dequeue_pos_ + 1)
+            return false;
+
+        task = std::move (s.task);
+        s.seq.store (dequeue_pos_ + mask_ + 1, std::memory_order_release);
+
+        ++dequeue_pos_;
+
+        return true;
+    }
+
+    bool empty () const noexcept {
+        return slots_ [dequeue_pos_ & mask_].seq.load (
+            std::memory_order_acquire) != dequeue_pos_ + 1;
+    }
+
+    void wake () noexcept {
+        std::atomic_thread_fence (std::memory_order_seq_cst);
+
+        if (sleeping_.load (std::memory_order_relaxed)) {
+            {
+                std::lock_guard< std::mutex > lock (mutex_);
+                sleeping_.store (false, std::memory_order_relaxed);
+            }
+
+            cv_.notify_one ();
+        }
+    }
+
+    void notify_waiters () noexcept {
+        if (waiters_.load ()) {
+            { std::lock_guard< std::mutex > lock (mutex_); }
+            done_.notify_all ();
+        }
+    }
+
+    void run () noexcept {
+        for (task_type task; ; ) {
+            if (try_pop (task)) {
+                task ();
+                task = task_type ();
+
+                completed_.fetch_add (1);
+                notify_waiters ();
+
+                continue;
+            }
+
+            std::unique_lock< std::mutex > lock (mutex_);
+
+            sleeping_.store (true, std::memory_order_relaxed);
+            std::atomic_thread_fence (std::memory_order_seq_cst);
+
+            if (!empty ()) {
+                sleeping_.store (false, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (stop_)
+                return;
+
+            cv_.wait (lock, [&] {
+                return stop_ || !sleeping_.load (std::memory_order_relaxed);
+            });
+
+            sleeping_.store (false, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    const std::size_t mask_;
+    std::unique_ptr< slot [] > slots_;
+
+    const reaper_overflow policy_;
+
+    alignas (64) std::atomic< std::size_t > enqueue_pos_{ 0 };
+    alignas (64) std::size_t dequeue_pos_{ 0 };
+
+    std::atomic< std::size_t > completed_{ 0 };
+    std::atomic< int > waiters_{ 0 };
+
+    std::atomic< bool > sleeping_{ false };
+    bool stop_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable cv_, done_;
+
+    std::thread thread_;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Adapts a deleter so that unique_resource::reset hands the resource over to
+// a reaper instead of releasing it on the calling thread. The resource and
+// the deleter are copied into the reaper queue.
+//
+template< typename D >
+struct async_deleter {
+    //
+    // Value-initialized, a function pointer is null rather than indeterminate:
+    //
+    async_deleter ()
+        : deleter_ (), reaper_ (&reaper::instance ())
+        { }
+
+    explicit async_deleter (D d, reaper& r = reaper::instance ())
+        noexcept (std::is_nothrow_move_constructible_v< D >)
+        : deleter_ (std::move (d)), reaper_ (&r)
+        { }
+
+    template< typename R >
+    void operator() (const R& r) const noexcept {
+        reaper_->submit ([r, d = deleter_] () mutable { d (r); });
+    }
+
+    D& get_deleter () noexcept {
+        return deleter_;
+    }
+
+    const D& get_deleter () const noexcept {
+        return deleter_;
+    }
+
+    reaper& get_reaper () const noexcept {
+        return *reaper_;
+    }
+
+private:
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS D deleter_;
+    reaper* reaper_;
+};
+
+template< typename R, typename D >
+struct invalid_resource_traits< R, async_deleter< D > >
+    : invalid_resource_traits< R, D > { };
+
+}}
+
+#endif // STD_ASYNC_DELETER_HPP
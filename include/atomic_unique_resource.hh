@@ -0,0 +1,362 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_ATOMIC_UNIQUE_RESOURCE_HPP
+#define STD_ATOMIC_UNIQUE_RESOURCE_HPP
+
+#include <unique_resource.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace std {
+namespace experimental {
+namespace detail {
+
+//
+// Hazard pointers (M. Michael, 2004). A reader publishes the value it is
+// about to use in a slot; a retired value is only released once no slot
+// holds it. Slots are never freed, threads keep theirs in a local cache.
+//
+struct hazard_slot {
+    std::atomic< std::uintptr_t > value{ 0 };
+    std::atomic< bool > active{ false };
+
+    hazard_slot* next = nullptr;
+    hazard_slot* next_free = nullptr;
+};
+
+struct hazard_domain {
+    hazard_slot* acquire () {
+        for (auto p = head_.load (std::memory_order_acquire); p; p = p->next) {
+            bool b = false;
+
+            if (!p->active.load (std::memory_order_relaxed) &&
+                p->active.compare_exchange_strong (b, true))
+                return p;
+        }
+
+        auto p = new hazard_slot;
+        p->active.store (true, std::memory_order_relaxed);
+
+        p->next = head_.load (std::memory_order_relaxed);
+
+        while (!head_.compare_exchange_weak (
+                   p->next, p, std::memory_order_release,
+                   std::memory_order_relaxed)) ;
+
+        return p;
+    }
+
+    void release (hazard_slot* p) noexcept {
+        p->value.store (0, std::memory_order_release);
+        p->active.store (false, std::memory_order_release);
+    }
+
+    //
+    // The values protected at the time of the call, sorted:
+    //
+    std::vector< std::uintptr_t > protected_values () const {
+        std::vector< std::uintptr_t > v;
+
+        for (auto p = head_.load (std::memory_order_acquire); p; p = p->next)
+            if (auto x = p->value.load ())
+                v.push_back (x);
+
+        std::sort (v.begin (), v.end ());
+        return v;
+    }
+
+    static hazard_domain& instance () noexcept {
+        static hazard_domain d;
+        return d;
+    }
+
+private:
+    std::atomic< hazard_slot* > head_{ nullptr };
+};
+
+struct hazard_cache {
+    ~hazard_cache () {
+        for (auto p = free_; p; p = p->next_free)
+            hazard_domain::instance ().release (p);
+    }
+
+    hazard_slot* pop () {
+        if (auto p = free_) {
+            free_ = p->next_free;
+            return p;
+        }
+
+        return hazard_domain::instance ().acquire ();
+    }
+
+    void push (hazard_slot* p) noexcept {
+        p->value.store (0, std::memory_order_release);
+
+        p->next_free = free_;
+        free_ = p;
+    }
+
+    static hazard_cache& instance () noexcept {
+        static thread_local hazard_cache x;
+        return x;
+    }
+
+private:
+    hazard_slot* free_ = nullptr;
+};
+
+//
+// A slot holds the bits of the value plus one, zero means empty; the value
+// with all bits set can therefore not be protected:
+//
+template< typename R >
+inline std::uintptr_t hazard_word (const R& r) noexcept {
+    std::uintptr_t x = 0;
+    std::memcpy (&x, &r, sizeof r);
+    return x + 1;
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Read access to a value loaded from an atomic_unique_resource. The value is
+// not released while the guard exists.
+//
+template< typename R >
+struct hazard_guard {
+    hazard_guard (const hazard_guard&) = delete;
+    hazard_guard& operator= (const hazard_guard&) = delete;
+
+    hazard_guard (hazard_guard&& other) noexcept
+        : value_ (other.value_), slot_ (std::exchange (other.slot_, nullptr))
+        { }
+
+    hazard_guard& operator= (hazard_guard&& other) noexcept {
+        if (this != &other) {
+            reset ();
+            value_ = other.value_;
+            slot_ = std::exchange (other.slot_, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~hazard_guard () {
+        reset ();
+    }
+
+    void reset () noexcept {
+        if (slot_)
+            detail::hazard_cache::instance ().push (
+                std::exchange (slot_, nullptr));
+    }
+
+    const R& get () const noexcept {
+        return value_;
+    }
+
+    operator const R& () const noexcept {
+        return value_;
+    }
+
+    R operator-> () const noexcept {
+        return value_;
+    }
+
+private:
+    template< typename, typename >
+    friend struct atomic_unique_resource;
+
+    hazard_guard (const R& r, detail::hazard_slot* p) noexcept
+        : value_ (r), slot_ (p)
+        { }
+
+private:
+    R value_;
+    detail::hazard_slot* slot_;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// A published resource that readers load without locking while writers
+// replace it. Replaced resources are retired and go through the deleter
+// once no reader holds a hazard_guard on them; the ones still protected at
+// that time are released by a later store or reclaim (), at the latest on
+// destruction.
+//
+// The resource must be trivially copyable and pointer-sized, and the
+// deleter must have an invalid_resource sentinel, the empty state. Values
+// must be unique while alive, as pointers and file descriptors are.
+//
+template< typename R, typename D >
+struct atomic_unique_resource {
+    static_assert (
+        std::is_trivially_copyable_v< R > && sizeof (R) <= sizeof (std::uintptr_t),
+        "resource must be trivially copyable and pointer-sized");
+
+    static_assert (
+        invalid_resource_traits< R, D >::value,
+        "deleter must have an invalid_resource");
+
+    using resource_type = unique_resource< R, D >;
+    using guard_type = hazard_guard< R >;
+
+private:
+    static constexpr R invalid () noexcept {
+        return invalid_resource_traits< R, D >::invalid ();
+    }
+
+    static bool same (const R& a, const R& b) noexcept {
+        return detail::hazard_word (a) == detail::hazard_word (b);
+    }
+
+public:
+    atomic_unique_resource () = default;
+
+    explicit atomic_unique_resource (D d)
+        : deleter_ (std::move (d))
+        { }
+
+    explicit atomic_unique_resource (resource_type&& r)
+        : deleter_ (r.get_deleter ()), current_ (r.release ())
+        { }
+
+    atomic_unique_resource (const atomic_unique_resource&) = delete;
+    atomic_unique_resource& operator= (const atomic_unique_resource&) = delete;
+
+    //
+    // No reader may be left:
+    //
+    ~atomic_unique_resource () {
+        const R r = current_.load (std::memory_order_relaxed);
+
+        if (!same (r, invalid ()))
+            deleter_.get ()(r);
+
+        for (auto& x : retired_)
+            deleter_.get ()(x);
+    }
+
+    //
+    // The current value, protected until the guard goes away:
+    //
+    guard_type load () const {
+        auto& cache = detail::hazard_cache::instance ();
+
+        detail::hazard_slot* p = cache.pop ();
+        R r = current_.load (std::memory_order_relaxed);
+
+        for (R x; !same (r, invalid ()); r = x) {
+            p->value.store (detail::hazard_word (r));
+
+            if (same (r, x = current_.load ()))
+                return guard_type (r, p);
+        }
+
+        cache.push (p);
+        return guard_type (r, nullptr);
+    }
+
+    //
+    // Publishes r, the deleter of the atomic_unique_resource is used for it:
+    //
+    void store (resource_type&& r) {
+        exchange (std::move (r));
+    }
+
+    //
+    // Publishes r and returns the retired value, which may only be compared:
+    //
+    R exchange (resource_type&& r) {
+        const R x = current_.exchange (r.release ());
+        retire (x);
+        return x;
+    }
+
+    //
+    // Publishes desired if the current value is expected, else loads the
+    // current value into expected and leaves desired alone:
+    //
+    bool compare_exchange (R& expected, resource_type& desired) {
+        const R x = expected;
+
+        if (!current_.compare_exchange_strong (expected, desired.get ()))
+            return false;
+
+        desired.release ();
+        retire (x);
+
+        return true;
+    }
+
+    void reset () {
+        store (resource_type (invalid (), deleter_.get ()));
+    }
+
+    //
+    // Releases the retired resources that are no longer protected:
+    //
+    void reclaim () {
+        std::lock_guard< std::mutex > lock (mutex_);
+        reclaim_locked ();
+    }
+
+    std::size_t retired () const {
+        std::lock_guard< std::mutex > lock (mutex_);
+        return retired_.size ();
+    }
+
+    const D& get_deleter () const noexcept {
+        return deleter_.get ();
+    }
+
+private:
+    void retire (const R& r) {
+        if (same (r, invalid ()))
+            return;
+
+        std::lock_guard< std::mutex > lock (mutex_);
+
+        retired_.push_back (r);
+        reclaim_locked ();
+    }
+
+    void reclaim_locked () {
+        if (retired_.empty ())
+            return;
+
+        const auto v = detail::hazard_domain::instance ().protected_values ();
+
+        auto last = std::partition (
+            retired_.begin (), retired_.end (), [&](const R& r) {
+                return std::binary_search (
+                    v.begin (), v.end (), detail::hazard_word (r));
+            });
+
+        for (auto i = last; i != retired_.end (); ++i)
+            deleter_.get ()(*i);
+
+        retired_.erase (last, retired_.end ());
+    }
+
+private:
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS detail::box< D > deleter_{ D () };
+    std::atomic< R > current_{ invalid () };
+
+    mutable std::mutex mutex_;
+    std::vector< R > retired_;
+};
+
+}}
+
+#endif // STD_ATOMIC_UNIQUE_RESOURCE_HPP
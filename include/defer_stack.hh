@@ -0,0 +1,182 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_DEFER_STACK_HPP
+#define STD_DEFER_STACK_HPP
+
+#include <unique_resource.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace std {
+namespace experimental {
+
+//
+// A stack of deferred calls, run in reverse order when the stack goes out of
+// scope, as Go's defer. Unlike a chain of scope guards, the callables share
+// one inline buffer of N bytes and one policy: the exit, fail or success
+// condition is captured once, and release () dismisses all calls. Callables
+// that do not fit the buffer go to heap blocks. The calls must not throw.
+//
+template< std::size_t N = 256, typename P = detail::scope_exit_policy >
+struct defer_stack : P {
+private:
+    struct entry {
+        void (*call) (entry*, bool) noexcept;
+        entry* prev;
+    };
+
+    template< typename F >
+    struct callable : entry {
+        template< typename G >
+        explicit callable (G&& g)
+            : entry { &callable::call_and_destroy, nullptr },
+              f (std::forward< G > (g))
+            { }
+
+        static void call_and_destroy (entry* p, bool run) noexcept {
+            auto q = static_cast< callable* > (p);
+
+            if (run)
+                q->f ();
+
+            q->~callable ();
+        }
+
+        F f;
+    };
+
+    struct alignas (std::max_align_t) block {
+        block* next;
+        std::size_t size;
+    };
+
+public:
+    defer_stack () noexcept = default;
+
+    defer_stack (const defer_stack&) = delete;
+    defer_stack& operator= (const defer_stack&) = delete;
+
+    ~defer_stack () {
+        const bool run = P::should_execute ();
+
+        for (entry* p = last_; p; ) {
+            entry* prev = p->prev;
+            p->call (p, run);
+            p = prev;
+        }
+
+        for (block* b = blocks_; b; )
+            ::operator delete (std::exchange (b, b->next));
+    }
+
+    //
+    // Pushes f. If that fails, f is called before the exception propagates
+    // if the stack would run it: not after release (), and never for a
+    // success stack, as a scope_success guard that failed to construct:
+    //
+    template< typename F >
+    void defer (F&& f) {
+        using callable_type = callable< std::decay_t< F > >;
+
+        auto guard = detail::make_rollback ([&, this] {
+            if constexpr (!std::is_same_v< P, detail::scope_success_policy >) {
+                if (P::should_execute ())
+                    f ();
+            }
+        });
+
+        void* p = allocate< callable_type > ();
+        auto q = ::new (p) callable_type (std::forward< F > (f));
+
+        guard.release ();
+
+        q->prev = last_;
+        last_ = q;
+
+        ++size_;
+    }
+
+    template< typename F >
+    defer_stack& operator+= (F&& f) {
+        defer (std::forward< F > (f));
+        return *this;
+    }
+
+    //
+    // Dismisses all calls, made so far or later:
+    //
+    void release () noexcept {
+        P::release ();
+    }
+
+    std::size_t size () const noexcept {
+        return size_;
+    }
+
+private:
+    static char* align (char* p, std::size_t a) noexcept {
+        const auto x = reinterpret_cast< std::uintptr_t > (p);
+        return p + ((a - x % a) % a);
+    }
+
+    //
+    // Sizes are rounded up so that the position stays aligned for entries,
+    // only over-aligned callables need to align it further:
+    //
+    template< typename T >
+    void* allocate () {
+        constexpr std::size_t a = alignof (T);
+        constexpr std::size_t n =
+            (sizeof (T) + alignof (entry) - 1) / alignof (entry) * alignof (entry);
+
+        char* p = a > alignof (entry) ? align (pos_, a) : pos_;
+
+        if (p + n > end_) {
+            const std::size_t size =
+                sizeof (block) + (std::max) (2 * N, n + a);
+
+            block* b = static_cast< block* > (::operator new (size));
+            b->next = blocks_;
+            b->size = size;
+
+            blocks_ = b;
+
+            pos_ = reinterpret_cast< char* > (b + 1);
+            end_ = reinterpret_cast< char* > (b) + size;
+
+            p = align (pos_, a);
+        }
+
+        pos_ = p + n;
+        return p;
+    }
+
+private:
+    alignas (std::max_align_t) char buffer_ [N];
+
+    char* pos_ = buffer_;
+    char* end_ = buffer_ + N;
+
+    entry* last_ = nullptr;
+    block* blocks_ = nullptr;
+
+    std::size_t size_ = 0;
+};
+
+template< std::size_t N = 256 >
+using defer_exit_stack = defer_stack< N, detail::scope_exit_policy >;
+
+template< std::size_t N = 256 >
+using defer_fail_stack = defer_stack< N, detail::scope_fail_policy >;
+
+template< std::size_t N = 256 >
+using defer_success_stack = defer_stack< N, detail::scope_success_policy >;
+
+}}
+
+#endif // STD_DEFER_STACK_HPP
@@ -0,0 +1,59 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_FD_DELETE_HPP
+#define STD_FD_DELETE_HPP
+
+#include <unique_resource.hh>
+
+#include <cstddef>
+
+#include <unistd.h>
+
+//
+// close_range (2) is in glibc since 2.34:
+//
+#if defined (__GLIBC__) && defined (_GNU_SOURCE)
+#  if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34)
+#    define UNIQUE_RESOURCE_HAVE_CLOSE_RANGE 1
+#  endif
+#endif
+
+namespace std {
+namespace experimental {
+
+//
+// File descriptor deleter, with -1 as the invalid value. The bulk form
+// closes each run of consecutive descriptors with one close_range (2):
+//
+struct fd_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int fd) const noexcept {
+        ::close (fd);
+    }
+
+    void operator() (const int* first, std::size_t n) const noexcept {
+        for (const int* last = first + n; first != last; ) {
+            const int* p = first + 1;
+
+            for (; p != last && *p == p [-1] + 1; ++p) ;
+
+#if defined (UNIQUE_RESOURCE_HAVE_CLOSE_RANGE)
+            if (p - first > 1 && 0 == ::close_range (
+                    unsigned (*first), unsigned (p [-1]), 0)) {
+                first = p;
+                continue;
+            }
+#endif // UNIQUE_RESOURCE_HAVE_CLOSE_RANGE
+
+            for (; first != p; ++first)
+                ::close (*first);
+        }
+    }
+};
+
+using unique_fd = unique_resource< int, fd_delete >;
+
+}}
+
+#endif // STD_FD_DELETE_HPP
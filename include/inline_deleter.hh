@@ -0,0 +1,133 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_INLINE_DELETER_HPP
+#define STD_INLINE_DELETER_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace std {
+namespace experimental {
+
+//
+// A type-erased callable with a fixed-capacity inline buffer and no heap
+// fallback, a replacement for std::function as a unique_resource deleter.
+// Callables that do not fit in N bytes fail to compile. Moves never throw.
+//
+template< typename, std::size_t = 2 * sizeof (void*) >
+struct inline_deleter;
+
+template< typename R, typename ...Args, std::size_t N >
+struct inline_deleter< R (Args...), N > {
+private:
+    using invoke_type = R (*) (void*, Args&&...);
+
+    //
+    // Moves into the first argument and destroys the second, or destroys
+    // the second only when the first is null:
+    //
+    using manage_type = void (*) (void*, void*) noexcept;
+
+    template< typename F >
+    static constexpr auto is_trivial_v =
+        std::is_trivially_copyable_v< F > &&
+        std::is_trivially_destructible_v< F >;
+
+    template< typename F >
+    using enable_constructor = std::enable_if_t<
+        !std::is_same_v< std::decay_t< F >, inline_deleter > &&
+        std::is_invocable_r_v< R, std::decay_t< F >&, Args... > >;
+
+    template< typename F >
+    static R invoke (void* p, Args&&... args) {
+        return (*static_cast< F* > (p)) (std::forward< Args > (args)...);
+    }
+
+    template< typename F >
+    static void manage (void* dst, void* src) noexcept {
+        F* f = static_cast< F* > (src);
+
+        if (dst)
+            ::new (dst) F (std::move (*f));
+
+        f->~F ();
+    }
+
+public:
+    inline_deleter () noexcept = default;
+
+    template< typename F, typename = enable_constructor< F > >
+    inline_deleter (F&& f)
+        noexcept (std::is_nothrow_constructible_v< std::decay_t< F >, F >) {
+        using T = std::decay_t< F >;
+
+        static_assert (
+            sizeof (T) <= N, "callable does not fit in inline_deleter");
+
+        static_assert (
+            alignof (T) <= alignof (void*),
+            "callable is over-aligned for inline_deleter");
+
+        static_assert (
+            std::is_nothrow_move_constructible_v< T >,
+            "callable must be nothrow_move_constructible");
+
+        ::new (static_cast< void* > (buf_)) T (std::forward< F > (f));
+
+        invoke_ = &inline_deleter::invoke< T >;
+
+        if constexpr (!is_trivial_v< T >)
+            manage_ = &inline_deleter::manage< T >;
+    }
+
+    inline_deleter (inline_deleter&& other) noexcept
+        : invoke_ (other.invoke_), manage_ (other.manage_) {
+        if (manage_)
+            manage_ (buf_, other.buf_);
+        else
+            std::memcpy (buf_, other.buf_, N);
+
+        other.invoke_ = nullptr;
+        other.manage_ = nullptr;
+    }
+
+    inline_deleter& operator= (inline_deleter&& other) noexcept {
+        if (this != &other) {
+            this->~inline_deleter ();
+            ::new (static_cast< void* > (this)) inline_deleter (std::move (other));
+        }
+
+        return *this;
+    }
+
+    inline_deleter (const inline_deleter&) = delete;
+    inline_deleter& operator= (const inline_deleter&) = delete;
+
+    ~inline_deleter () {
+        if (manage_)
+            manage_ (nullptr, buf_);
+    }
+
+    R operator() (Args... args) const {
+        assert (invoke_);
+        return invoke_ (buf_, std::forward< Args > (args)...);
+    }
+
+    explicit operator bool () const noexcept {
+        return invoke_;
+    }
+
+private:
+    alignas (void*) mutable unsigned char buf_ [N];
+
+    invoke_type invoke_ = nullptr;
+    manage_type manage_ = nullptr;
+};
+
+}}
+
+#endif // STD_INLINE_DELETER_HPP
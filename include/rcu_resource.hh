@@ -0,0 +1,193 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_RCU_RESOURCE_HPP
+#define STD_RCU_RESOURCE_HPP
+
+#include <unique_resource.hh>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace std {
+namespace experimental {
+
+//
+// Read-copy-update grace periods. Every thread has a reader record on its
+// own cache line, holding the epoch at which its outermost read-side section
+// started, or zero outside of one. A grace period advances the epoch and
+// waits for the records that started before it; readers never write shared
+// state. Records of exited threads are reused, never freed.
+//
+struct rcu_domain {
+private:
+    struct alignas (64) record {
+        std::atomic< std::uint64_t > epoch{ 0 };
+        std::atomic< bool > active{ true };
+
+        unsigned nesting = 0;
+        record* next = nullptr;
+    };
+
+    struct thread_record {
+        ~thread_record () {
+            p->active.store (false, std::memory_order_release);
+        }
+
+        record* const p = rcu_domain::instance ().acquire ();
+    };
+
+    rcu_domain () = default;
+
+public:
+    rcu_domain (const rcu_domain&) = delete;
+    rcu_domain& operator= (const rcu_domain&) = delete;
+
+    void read_lock () noexcept {
+        record& r = this_record ();
+
+        //
+        // Acquire: seeing the epoch of a synchronize () is seeing the new
+        // resource it was called for, not the one it is about to release:
+        //
+        if (0 == r.nesting++)
+            r.epoch.store (epoch_.load (std::memory_order_acquire));
+    }
+
+    void read_unlock () noexcept {
+        record& r = this_record ();
+
+        if (0 == --r.nesting)
+            r.epoch.store (0, std::memory_order_release);
+    }
+
+    //
+    // Waits until every read-side section that started before the call has
+    // ended. Must not be called from within one:
+    //
+    void synchronize () noexcept {
+        std::lock_guard< std::mutex > lock (mutex_);
+
+        const auto target = epoch_.fetch_add (1) + 1;
+
+        for (auto p = head_.load (); p; p = p->next) {
+            for (std::uint64_t x; ; std::this_thread::yield ()) {
+                x = p->epoch.load ();
+
+                if (0 == x || target <= x)
+                    break;
+            }
+        }
+    }
+
+    static rcu_domain& instance () noexcept {
+        static rcu_domain d;
+        return d;
+    }
+
+private:
+    static record& this_record () noexcept {
+        static thread_local thread_record x;
+        return *x.p;
+    }
+
+    record* acquire () {
+        for (auto p = head_.load (); p; p = p->next) {
+            bool b = false;
+
+            if (!p->active.load (std::memory_order_relaxed) &&
+                p->active.compare_exchange_strong (b, true))
+                return p;
+        }
+
+        auto p = new record;
+        p->next = head_.load (std::memory_order_relaxed);
+
+        while (!head_.compare_exchange_weak (p->next, p)) ;
+
+        return p;
+    }
+
+private:
+    std::atomic< std::uint64_t > epoch_{ 1 };
+    std::atomic< record* > head_{ nullptr };
+
+    std::mutex mutex_;
+};
+
+//
+// A read-side section of the rcu_domain:
+//
+struct rcu_read_guard {
+    rcu_read_guard () noexcept {
+        rcu_domain::instance ().read_lock ();
+    }
+
+    rcu_read_guard (const rcu_read_guard&) = delete;
+    rcu_read_guard& operator= (const rcu_read_guard&) = delete;
+
+    ~rcu_read_guard () {
+        rcu_domain::instance ().read_unlock ();
+    }
+};
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// A read-mostly resource. Readers in a read-side section get a const R& that
+// stays valid until the section ends; writers publish a new unique_resource
+// and the old one is released after a grace period, on the writer's thread.
+// The resource lives in its own allocation, so R may be of any size.
+//
+template< typename R, typename D >
+struct rcu_resource {
+    using resource_type = unique_resource< R, D >;
+
+    explicit rcu_resource (resource_type&& r)
+        : current_ (new resource_type (std::move (r)))
+        { }
+
+    rcu_resource (const rcu_resource&) = delete;
+    rcu_resource& operator= (const rcu_resource&) = delete;
+
+    //
+    // No reader may be left:
+    //
+    ~rcu_resource () {
+        delete current_.load (std::memory_order_relaxed);
+    }
+
+    //
+    // The current resource, valid while the guard exists:
+    //
+    const R& read (const rcu_read_guard&) const noexcept {
+        return current_.load ()->get ();
+    }
+
+    template< typename F >
+    decltype (auto) read (F f) const {
+        rcu_read_guard guard;
+        return f (read (guard));
+    }
+
+    //
+    // Publishes r and waits for a grace period before releasing the old
+    // resource. Must not be called from a read-side section:
+    //
+    void store (resource_type&& r) {
+        auto p = new resource_type (std::move (r));
+
+        std::unique_ptr< resource_type > old (current_.exchange (p));
+        rcu_domain::instance ().synchronize ();
+    }
+
+private:
+    std::atomic< resource_type* > current_;
+};
+
+}}
+
+#endif // STD_RCU_RESOURCE_HPP
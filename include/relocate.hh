@@ -0,0 +1,254 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_RELOCATE_HPP
+#define STD_RELOCATE_HPP
+
+#include <unique_resource.hh>
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace std {
+namespace experimental {
+
+//
+// A type is trivially relocatable when moving it to new storage and ending
+// the lifetime of the source is equivalent to a memcpy of its bytes. May be
+// specialized for types that are not trivially copyable but hold no pointers
+// into themselves.
+//
+template< typename T >
+struct is_trivially_relocatable : std::is_trivially_copyable< T > { };
+
+template< typename T >
+constexpr auto is_trivially_relocatable_v = is_trivially_relocatable< T >::value;
+
+namespace detail {
+
+template< typename T >
+constexpr auto is_trivially_relocatable_member_v =
+    std::is_reference_v< T > || is_trivially_relocatable_v< T >;
+
+} // namespace detail
+
+template< typename R, typename D >
+struct is_trivially_relocatable< unique_resource< R, D > >
+    : std::integral_constant<
+    bool,
+    detail::is_trivially_relocatable_member_v< R > &&
+    detail::is_trivially_relocatable_member_v< D > > { };
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Move-constructs [first, last) into the uninitialized storage at d_first
+// and destroys the source objects, by memcpy when T is trivially
+// relocatable. Requires a non-throwing move constructor otherwise:
+//
+template< typename T >
+T* uninitialized_relocate (T* first, T* last, T* d_first) noexcept {
+    if constexpr (is_trivially_relocatable_v< T >) {
+        if (first != last)
+            std::memcpy (
+                static_cast< void* > (d_first), static_cast< void* > (first),
+                (last - first) * sizeof (T));
+
+        return d_first + (last - first);
+    }
+    else {
+        static_assert (
+            std::is_nothrow_move_constructible_v< T >,
+            "relocated type must be nothrow_move_constructible");
+
+        for (; first != last; ++first, ++d_first) {
+            ::new (static_cast< void* > (d_first)) T (std::move (*first));
+            first->~T ();
+        }
+
+        return d_first;
+    }
+}
+
+template< typename T >
+T* uninitialized_relocate_n (T* first, std::size_t n, T* d_first) noexcept {
+    return uninitialized_relocate (first, first + n, d_first);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// A minimal vector that grows by relocation, e.g., a table of file
+// descriptors that is never copied:
+//
+template< typename T, typename A = std::allocator< T > >
+struct relocating_vector : private A {
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+private:
+    using traits_type = std::allocator_traits< A >;
+
+    //
+    // Trivially relocatable elements in default-allocated storage grow in
+    // place with realloc, which may remap large blocks instead of copying:
+    //
+    static constexpr bool use_realloc_v =
+        is_trivially_relocatable_v< T > &&
+        std::is_same_v< A, std::allocator< T > > &&
+        alignof (T) <= alignof (std::max_align_t);
+
+public:
+    relocating_vector () noexcept (noexcept (A ())) = default;
+
+    explicit relocating_vector (const A& a) noexcept
+        : A (a)
+        { }
+
+    relocating_vector (relocating_vector&& other) noexcept
+        : A (std::move (static_cast< A& > (other))),
+          begin_ (std::exchange (other.begin_, nullptr)),
+          end_ (std::exchange (other.end_, nullptr)),
+          cap_ (std::exchange (other.cap_, nullptr))
+        { }
+
+    relocating_vector& operator= (relocating_vector&& other) noexcept {
+        relocating_vector (std::move (other)).swap (*this);
+        return *this;
+    }
+
+    relocating_vector (const relocating_vector&) = delete;
+    relocating_vector& operator= (const relocating_vector&) = delete;
+
+    ~relocating_vector () {
+        clear ();
+
+        if (begin_)
+            deallocate ();
+    }
+
+    void swap (relocating_vector& other) noexcept {
+        using std::swap;
+        swap (static_cast< A& > (*this), static_cast< A& > (other));
+        swap (begin_, other.begin_);
+        swap (end_, other.end_);
+        swap (cap_, other.cap_);
+    }
+
+    template< typename ...Args >
+    T& emplace_back (Args&&... args) {
+        if (end_ == cap_) {
+            //
+            // Construct first, the arguments may refer to existing elements:
+            //
+            T t (std::forward< Args > (args)...);
+            grow (size () ? 2 * size () : 1);
+            return *::new (static_cast< void* > (end_++)) T (std::move (t));
+        }
+
+        return *::new (static_cast< void* > (end_++)) T (
+            std::forward< Args > (args)...);
+    }
+
+    void push_back (T&& t) {
+        emplace_back (std::move (t));
+    }
+
+    void pop_back () noexcept {
+        (--end_)->~T ();
+    }
+
+    void reserve (size_type n) {
+        if (n > capacity ())
+            grow (n);
+    }
+
+    void clear () noexcept {
+        for (; end_ != begin_; )
+            (--end_)->~T ();
+    }
+
+    size_type size () const noexcept {
+        return end_ - begin_;
+    }
+
+    size_type capacity () const noexcept {
+        return cap_ - begin_;
+    }
+
+    bool empty () const noexcept {
+        return begin_ == end_;
+    }
+
+    T& operator[] (size_type i) noexcept {
+        return begin_ [i];
+    }
+
+    const T& operator[] (size_type i) const noexcept {
+        return begin_ [i];
+    }
+
+    T* data () noexcept { return begin_; }
+    const T* data () const noexcept { return begin_; }
+
+    iterator begin () noexcept { return begin_; }
+    iterator end () noexcept { return end_; }
+
+    const_iterator begin () const noexcept { return begin_; }
+    const_iterator end () const noexcept { return end_; }
+
+private:
+    void grow (size_type n) {
+        T* p;
+        T* q;
+
+        if constexpr (use_realloc_v) {
+            p = static_cast< T* > (std::realloc (
+                static_cast< void* > (begin_), n * sizeof (T)));
+
+            if (0 == p) {
+#if defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+                std::abort ();
+#else
+                throw std::bad_alloc ();
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+            }
+
+            q = p + size ();
+        }
+        else {
+            p = q = traits_type::allocate (*this, n);
+
+            if (begin_) {
+                q = uninitialized_relocate (begin_, end_, p);
+                deallocate ();
+            }
+        }
+
+        begin_ = p;
+        end_ = q;
+        cap_ = p + n;
+    }
+
+    void deallocate () noexcept {
+        if constexpr (use_realloc_v)
+            std::free (begin_);
+        else
+            traits_type::deallocate (*this, begin_, capacity ());
+    }
+
+private:
+    T* begin_ = nullptr;
+    T* end_ = nullptr;
+    T* cap_ = nullptr;
+};
+
+}}
+
+#endif // STD_RELOCATE_HPP
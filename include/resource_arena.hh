@@ -0,0 +1,214 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_RESOURCE_ARENA_HPP
+#define STD_RESOURCE_ARENA_HPP
+
+#include <unique_resource.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace std {
+namespace experimental {
+
+//
+// Owns many resources registered over one scope, a request for instance, and
+// releases all of them at once, in reverse order of registration, on clear ()
+// or destruction. Each resource is a unique_resource in a bump-allocated
+// block, linked to the previous one; the arena hands out references to them,
+// which stay valid until the next clear (). clear () keeps the first block
+// for reuse.
+//
+struct resource_arena {
+private:
+    struct record {
+        void (*destroy) (record*) noexcept;
+        record* prev;
+    };
+
+    template< typename R, typename D >
+    struct node : record {
+        template< typename ...Args >
+        explicit node (Args&&... args)
+            : record { &node::destroy_node, nullptr },
+              resource (std::forward< Args > (args)...)
+            { }
+
+        static void destroy_node (record* p) noexcept {
+            static_cast< node* > (p)->~node ();
+        }
+
+        unique_resource< R, D > resource;
+    };
+
+    struct alignas (std::max_align_t) block {
+        block* next;
+        std::size_t size;
+    };
+
+public:
+    explicit resource_arena (std::size_t block_size = 4096) noexcept
+        : block_size_ (block_size)
+        { }
+
+    resource_arena (const resource_arena&) = delete;
+    resource_arena& operator= (const resource_arena&) = delete;
+
+    ~resource_arena () {
+        clear ();
+
+        if (blocks_)
+            ::operator delete (blocks_);
+    }
+
+    //
+    // Registers t, released with u. If registration fails, u (t) runs before
+    // the exception propagates, as with unique_resource:
+    //
+    template< typename T, typename U >
+    unique_resource< std::decay_t< T >, std::decay_t< U > >&
+    emplace (T&& t, U&& u) {
+        using node_type = node< std::decay_t< T >, std::decay_t< U > >;
+
+        auto guard = detail::make_rollback ([&] { u (t); });
+        void* p = allocate (sizeof (node_type), alignof (node_type));
+        guard.release ();
+
+        auto q = ::new (p) node_type (std::forward< T > (t), std::forward< U > (u));
+
+        return push (q)->resource;
+    }
+
+    //
+    // As above, but t is only released if it is not the invalid value s:
+    //
+    template< typename T, typename U, typename S = std::decay_t< T > >
+    unique_resource< std::decay_t< T >, std::decay_t< U > >&
+    emplace_checked (T&& t, const S& s, U&& u) {
+        using node_type = node< std::decay_t< T >, std::decay_t< U > >;
+
+        const bool b = t != s;
+
+        auto guard = detail::make_rollback ([&] { if (b) u (t); });
+        void* p = allocate (sizeof (node_type), alignof (node_type));
+        guard.release ();
+
+        auto q = ::new (p) node_type (
+            std::forward< T > (t), std::forward< U > (u), b);
+
+        return push (q)->resource;
+    }
+
+    //
+    // Takes over r; r still owns its resource if allocation fails:
+    //
+    template< typename R, typename D >
+    unique_resource< R, D >& adopt (unique_resource< R, D >&& r) {
+        using node_type = node< R, D >;
+
+        void* p = allocate (sizeof (node_type), alignof (node_type));
+
+        auto q = ::new (p) node_type (std::move (r));
+
+        return push (q)->resource;
+    }
+
+    //
+    // Releases all resources, the last registered first:
+    //
+    void clear () noexcept {
+        for (record* p = last_; p; ) {
+            record* prev = p->prev;
+            p->destroy (p);
+            p = prev;
+        }
+
+        last_ = nullptr;
+        size_ = 0;
+
+        if (blocks_) {
+            for (block* b = std::exchange (blocks_->next, nullptr); b; )
+                ::operator delete (std::exchange (b, b->next));
+
+            current_ = blocks_;
+            pos_ = data_of (blocks_);
+            end_ = reinterpret_cast< char* > (blocks_) + blocks_->size;
+        }
+    }
+
+    std::size_t size () const noexcept {
+        return size_;
+    }
+
+    bool empty () const noexcept {
+        return 0 == size_;
+    }
+
+private:
+    static char* data_of (block* b) noexcept {
+        return reinterpret_cast< char* > (b + 1);
+    }
+
+    template< typename T >
+    T* push (T* p) noexcept {
+        p->prev = last_;
+        last_ = p;
+        ++size_;
+        return p;
+    }
+
+    void* allocate (std::size_t n, std::size_t a) {
+        char* p = align (pos_, a);
+
+        if (0 == pos_ || p + n > end_) {
+            grow (n + a);
+            p = align (pos_, a);
+        }
+
+        pos_ = p + n;
+        return p;
+    }
+
+    static char* align (char* p, std::size_t a) noexcept {
+        const auto x = reinterpret_cast< std::uintptr_t > (p);
+        return p + ((a - x % a) % a);
+    }
+
+    void grow (std::size_t n) {
+        const std::size_t size = sizeof (block) + (std::max) (block_size_, n);
+
+        block* b = static_cast< block* > (::operator new (size));
+        b->next = nullptr;
+        b->size = size;
+
+        if (current_)
+            current_->next = b;
+        else
+            blocks_ = b;
+
+        current_ = b;
+
+        pos_ = data_of (b);
+        end_ = reinterpret_cast< char* > (b) + size;
+    }
+
+private:
+    const std::size_t block_size_;
+
+    block* blocks_ = nullptr;
+    block* current_ = nullptr;
+
+    char* pos_ = nullptr;
+    char* end_ = nullptr;
+
+    record* last_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+}}
+
+#endif // STD_RESOURCE_ARENA_HPP
@@ -0,0 +1,354 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_RESOURCE_POOL_HPP
+#define STD_RESOURCE_POOL_HPP
+
+#include <unique_resource.hh>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace std {
+namespace experimental {
+
+//
+// A pool of recycled resources. acquire () hands out a unique_resource
+// whose deleter puts the resource back into the pool; the real deleter only
+// runs for resources beyond the idle limit, on trim, and on destruction.
+//
+// Released resources go to a per-thread cache first. Full caches spill half
+// their content, as one batch, to a global lock-free list shared by all
+// threads, which holds at most max_idle resources.
+//
+// The factory may be called concurrently. The pool must outlive the
+// handles it gives out; idle resources cached by other threads are released
+// when those threads exit.
+//
+template< typename R, typename F, typename D >
+struct resource_pool {
+    static_assert (
+        std::is_nothrow_move_constructible_v< R >,
+        "pooled resource must be nothrow_move_constructible");
+
+    static_assert (
+        alignof (R) <= alignof (std::max_align_t),
+        "pooled resource must not be over-aligned");
+
+private:
+    struct state;
+
+    struct batch {
+        batch* next;
+        std::size_t size;
+    };
+
+    static constexpr std::size_t batch_offset =
+        (sizeof (batch) + alignof (R) - 1) / alignof (R) * alignof (R);
+
+    static R* items_of (batch* b) noexcept {
+        return reinterpret_cast< R* > (
+            reinterpret_cast< char* > (b) + batch_offset);
+    }
+
+    struct state {
+        state (F f, D d, std::size_t max_idle, std::size_t cache_size)
+            : factory (std::move (f)), deleter (std::move (d)),
+              max_idle (max_idle), cache_size (cache_size < 2 ? 2 : cache_size)
+            { }
+
+        ~state () {
+            drain (0);
+        }
+
+        void destroy (R& r) noexcept {
+            deleter (r);
+            r.~R ();
+        }
+
+        void destroy (batch* b) noexcept {
+            for (std::size_t i = 0; i < b->size; ++i)
+                destroy (items_of (b) [i]);
+
+            ::operator delete (b);
+        }
+
+        void push (batch* first, batch* last) noexcept {
+            auto p = head.load (std::memory_order_relaxed);
+
+            do {
+                last->next = p;
+            } while (!head.compare_exchange_weak (
+                         p, first, std::memory_order_release,
+                         std::memory_order_relaxed));
+        }
+
+        //
+        // Takes the whole list, which is ABA-free, and puts back the tail:
+        //
+        batch* pop () noexcept {
+            batch* p = head.exchange (nullptr, std::memory_order_acquire);
+
+            if (p && p->next) {
+                batch* last = p->next;
+                for (; last->next; last = last->next) ;
+                push (p->next, last);
+            }
+
+            if (p)
+                idle.fetch_sub (p->size, std::memory_order_relaxed);
+
+            return p;
+        }
+
+        //
+        // Moves the last n items of v into a new batch on the global list,
+        // or releases them if that would exceed the idle limit:
+        //
+        void spill (std::vector< R >& v, std::size_t n) noexcept {
+            if (0 == n)
+                return;
+
+            batch* b = nullptr;
+
+            if (idle.fetch_add (n, std::memory_order_relaxed) + n <= max_idle)
+                b = static_cast< batch* > (::operator new (
+                    batch_offset + n * sizeof (R), std::nothrow));
+
+            if (0 == b) {
+                idle.fetch_sub (n, std::memory_order_relaxed);
+
+                for (; n; --n) {
+                    deleter (v.back ());
+                    v.pop_back ();
+                }
+
+                return;
+            }
+
+            b->size = n;
+
+            for (R* p = items_of (b) + n; n; --n) {
+                ::new (static_cast< void* > (--p)) R (std::move (v.back ()));
+                v.pop_back ();
+            }
+
+            push (b, b);
+        }
+
+        //
+        // Releases global batches until at most n resources remain idle:
+        //
+        void drain (std::size_t n) noexcept {
+            batch* p = head.exchange (nullptr, std::memory_order_acquire);
+
+            while (p && idle.load (std::memory_order_relaxed) > n) {
+                idle.fetch_sub (p->size, std::memory_order_relaxed);
+                destroy (std::exchange (p, p->next));
+            }
+
+            if (p) {
+                batch* last = p;
+                for (; last->next; last = last->next) ;
+                push (p, last);
+            }
+        }
+
+        F factory;
+        D deleter;
+
+        const std::size_t max_idle, cache_size;
+
+        std::atomic< batch* > head{ nullptr };
+        std::atomic< std::size_t > idle{ 0 };
+        std::atomic< bool > alive{ true };
+    };
+
+    struct cache {
+        std::shared_ptr< state > owner;
+        std::vector< R > items;
+    };
+
+    //
+    // The calling thread's caches, one per pool it has used:
+    //
+    struct thread_caches {
+        ~thread_caches () {
+            for (auto& c : caches) {
+                auto& s = *c.owner;
+
+                if (s.alive.load (std::memory_order_acquire))
+                    s.spill (c.items, c.items.size ());
+                else
+                    for (auto& r : c.items)
+                        s.deleter (r);
+            }
+        }
+
+        std::vector< cache > caches;
+    };
+
+    static thread_caches& caches () noexcept {
+        static thread_local thread_caches x;
+        return x;
+    }
+
+    cache* find_cache () const noexcept {
+        for (auto& c : caches ().caches)
+            if (c.owner == state_)
+                return &c;
+
+        return nullptr;
+    }
+
+    cache& make_cache () const {
+        cache c { state_, { } };
+        c.items.reserve (state_->cache_size);
+
+        caches ().caches.push_back (std::move (c));
+        return caches ().caches.back ();
+    }
+
+public:
+    //
+    // Puts resources back into the pool it came from:
+    //
+    struct return_to_pool {
+        void operator() (R& r) const noexcept {
+            pool->put (r);
+        }
+
+        resource_pool* pool;
+    };
+
+    using handle_type = unique_resource< R, return_to_pool >;
+
+public:
+    explicit resource_pool (
+        F f = F (), D d = D (), std::size_t max_idle = 1024,
+        std::size_t cache_size = 32)
+        : state_ (std::make_shared< state > (
+                      std::move (f), std::move (d), max_idle, cache_size))
+        { }
+
+    resource_pool (const resource_pool&) = delete;
+    resource_pool& operator= (const resource_pool&) = delete;
+
+    ~resource_pool () {
+        state_->alive.store (false, std::memory_order_release);
+        trim ();
+
+        auto& v = caches ().caches;
+
+        for (auto i = v.begin (); i != v.end (); ++i) {
+            if (i->owner == state_) {
+                v.erase (i);
+                break;
+            }
+        }
+    }
+
+    handle_type acquire () {
+        cache* c = find_cache ();
+
+        if (0 == c)
+            c = &make_cache ();
+
+        auto& v = c->items;
+
+        if (v.empty ()) {
+            if (batch* b = state_->pop ()) {
+                R* p = items_of (b);
+
+                for (std::size_t i = 0; i < b->size; ++i) {
+                    v.push_back (std::move (p [i]));
+                    p [i].~R ();
+                }
+
+                ::operator delete (b);
+            }
+        }
+
+        if (v.empty ())
+            return handle_type (state_->factory (), return_to_pool { this });
+
+        handle_type h (std::move (v.back ()), return_to_pool { this });
+        v.pop_back ();
+
+        return h;
+    }
+
+    //
+    // Releases idle resources, all of the calling thread's cache and global
+    // ones beyond n:
+    //
+    void trim (std::size_t n = 0) noexcept {
+        if (cache* c = find_cache ()) {
+            for (auto& r : c->items)
+                state_->deleter (r);
+
+            c->items.clear ();
+        }
+
+        state_->drain (n);
+    }
+
+    //
+    // Idle resources in the global list, excluding per-thread caches:
+    //
+    std::size_t idle () const noexcept {
+        return state_->idle.load (std::memory_order_relaxed);
+    }
+
+private:
+    void put (R& r) noexcept {
+        cache* c = find_cache ();
+
+        //
+        // A thread may release without ever acquiring from the pool, it gets
+        // a cache all the same:
+        //
+        if (0 == c) {
+            UNIQUE_RESOURCE_TRY {
+                c = &make_cache ();
+            }
+            UNIQUE_RESOURCE_CATCH (...) { }
+        }
+
+        if (0 == c) {
+            //
+            // Out of memory for a cache, let the global list have it:
+            //
+            std::vector< R > v;
+
+            UNIQUE_RESOURCE_TRY {
+                v.reserve (1);
+                v.push_back (std::move (r));
+            }
+            UNIQUE_RESOURCE_CATCH (...) {
+                state_->deleter (r);
+                return;
+            }
+
+            state_->spill (v, 1);
+            return;
+        }
+
+        auto& v = c->items;
+
+        if (v.size () == state_->cache_size)
+            state_->spill (v, v.size () / 2);
+
+        v.push_back (std::move (r));
+    }
+
+private:
+    std::shared_ptr< state > state_;
+};
+
+}}
+
+#endif // STD_RESOURCE_POOL_HPP
@@ -0,0 +1,426 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_RESOURCE_STATS_HPP
+#define STD_RESOURCE_STATS_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined (__x86_64__) || defined (__i386__)
+#  include <x86intrin.h>
+#endif
+
+#if defined (UNIQUE_RESOURCE_TRACKING)
+#  include <resource_tracker.hh>
+#endif
+
+#if !defined (UNIQUE_RESOURCE_INSTRUMENTATION_PERIOD)
+#  define UNIQUE_RESOURCE_INSTRUMENTATION_PERIOD 64
+#endif
+
+namespace std {
+namespace experimental {
+
+//
+// Lifetime statistics of one unique_resource or scope_guard type, collected
+// when UNIQUE_RESOURCE_INSTRUMENTATION is defined (in all translation units).
+// For a unique_resource, releases count both deleter invocations and calls
+// to release (), which also count as leaks; for a scope_guard, releases are
+// destructions and invocations the calls of the guarded function. The
+// histograms count the sampled lifetimes and deleter latencies: bucket 0
+// those under 1 ns, bucket i > 0 those in [2^(i-1), 2^i) ns.
+//
+struct resource_stats {
+    static constexpr std::size_t buckets = 65;
+
+    using histogram = std::array< std::uint64_t, buckets >;
+
+    std::string type;
+
+    std::uint64_t acquisitions = 0;
+    std::uint64_t releases = 0;
+    std::uint64_t leaks = 0;
+    std::uint64_t invocations = 0;
+
+    histogram lifetime = { };
+    histogram latency = { };
+
+    std::uint64_t live () const noexcept {
+        return acquisitions - releases;
+    }
+};
+
+namespace detail {
+
+//
+// The time stamp counter where there is one, scaled to nanoseconds when
+// durations are recorded; the steady clock, much slower to read, elsewhere:
+//
+struct stats_clock {
+#if defined (__x86_64__) || defined (__i386__)
+    static std::uint64_t now () noexcept {
+        return __rdtsc ();
+    }
+
+    static std::uint64_t to_nanoseconds (std::uint64_t ticks) noexcept {
+        static const std::uint64_t scale = calibrate ();
+        return (unsigned __int128) (ticks) * scale >> 32;
+    }
+
+private:
+    //
+    // Nanoseconds per tick, a 32.32 fixed-point number, over 1 ms:
+    //
+    static std::uint64_t calibrate () noexcept {
+        using namespace std::chrono;
+
+        const auto t0 = steady_clock::now ();
+        const auto c0 = __rdtsc ();
+
+        auto t1 = t0;
+
+        while (t1 - t0 < milliseconds (1))
+            t1 = steady_clock::now ();
+
+        const auto c1 = __rdtsc ();
+
+        const std::uint64_t ns = duration_cast< nanoseconds > (t1 - t0).count ();
+        return c1 > c0 ? (ns << 32) / (c1 - c0) : std::uint64_t (1) << 32;
+    }
+#else
+    static std::uint64_t now () noexcept {
+        using namespace std::chrono;
+
+        const auto t = steady_clock::now ().time_since_epoch ();
+        return duration_cast< nanoseconds > (t).count ();
+    }
+
+    static std::uint64_t to_nanoseconds (std::uint64_t ticks) noexcept {
+        return ticks;
+    }
+#endif
+};
+
+//
+// The counters of one type in one thread. Only the thread writes them, with
+// plain loads and stores; snapshots read them concurrently:
+//
+struct stats_counters {
+    using counter = std::atomic< std::uint64_t >;
+
+    static std::uint64_t increment (counter& c, std::uint64_t n = 1) noexcept {
+        n += c.load (std::memory_order_relaxed);
+        c.store (n, std::memory_order_relaxed);
+        return n;
+    }
+
+    static std::size_t bucket (std::uint64_t ticks) noexcept {
+        const auto ns = stats_clock::to_nanoseconds (ticks);
+        return ns ? 64 - __builtin_clzll (ns) : 0;
+    }
+
+    void add_to (resource_stats& s) const noexcept {
+        s.acquisitions += acquisitions.load (std::memory_order_relaxed);
+        s.releases += releases.load (std::memory_order_relaxed);
+        s.leaks += leaks.load (std::memory_order_relaxed);
+        s.invocations += invocations.load (std::memory_order_relaxed);
+
+        for (std::size_t i = 0; i < resource_stats::buckets; ++i) {
+            s.lifetime [i] += lifetime [i].load (std::memory_order_relaxed);
+            s.latency [i] += latency [i].load (std::memory_order_relaxed);
+        }
+    }
+
+    counter acquisitions{ 0 }, releases{ 0 }, leaks{ 0 }, invocations{ 0 };
+    counter lifetime [resource_stats::buckets] = { };
+    counter latency [resource_stats::buckets] = { };
+};
+
+//
+// All counters of one type: those of live threads, and the sum of those of
+// exited threads. Records are never freed:
+//
+struct stats_record {
+    explicit stats_record (const char* s) noexcept : name (s) { }
+
+    const char* name;
+
+    std::mutex mutex;
+    std::vector< stats_counters* > threads;
+    resource_stats retired;
+
+    stats_record* next = nullptr;
+};
+
+struct stats_registry {
+    void add (stats_record* p) noexcept {
+        p->next = head.load (std::memory_order_relaxed);
+        while (!head.compare_exchange_weak (p->next, p)) ;
+    }
+
+    static stats_registry& instance () noexcept {
+        static stats_registry x;
+        return x;
+    }
+
+    std::atomic< stats_record* > head{ nullptr };
+};
+
+//
+// The type's name, out of the compiler's function signature:
+//
+template< typename T >
+const char* stats_type_name () noexcept {
+    return __PRETTY_FUNCTION__;
+}
+
+template< typename T >
+stats_record& stats_record_of () noexcept {
+    static stats_record* p = [] {
+        auto q = new stats_record (stats_type_name< T > ());
+        stats_registry::instance ().add (q);
+        return q;
+    } ();
+
+    return *p;
+}
+
+template< typename T >
+struct stats_thread {
+    stats_thread () {
+        std::lock_guard< std::mutex > lock (record.mutex);
+        record.threads.push_back (&counters);
+    }
+
+    ~stats_thread () {
+        std::lock_guard< std::mutex > lock (record.mutex);
+
+        counters.add_to (record.retired);
+
+        auto& v = record.threads;
+        v.erase (std::find (v.begin (), v.end (), &counters));
+
+        exited () = true;
+    }
+
+    //
+    // Trivially destructible, still there after the counters:
+    //
+    static bool& exited () noexcept {
+        static thread_local bool x /* = false */;
+        return x;
+    }
+
+    stats_record& record = stats_record_of< T > ();
+    stats_counters counters;
+};
+
+//
+// Updates the counters of type T in this thread with f (c). Once they are
+// destroyed at thread exit (e.g., for a static resource released at program
+// exit), the update goes to the retired counters, under the record's mutex:
+//
+template< typename T, typename F >
+void stats_update (F f) noexcept {
+    if (!stats_thread< T >::exited ()) {
+        static thread_local stats_thread< T > x;
+        f (x.counters);
+    }
+    else {
+        auto& r = stats_record_of< T > ();
+
+        stats_counters c;
+        f (c);
+
+        std::lock_guard< std::mutex > lock (r.mutex);
+        c.add_to (r.retired);
+    }
+}
+
+//
+// The instrumentation a unique_resource or a scope_guard carries: the time
+// its current resource was acquired, one if that was not sampled, zero when
+// it holds none. Reading the clock costs more than all counters together,
+// only one acquisition in UNIQUE_RESOURCE_INSTRUMENTATION_PERIOD is timed,
+// along with the invocation of its deleter. T is the type the statistics
+// are kept for. With UNIQUE_RESOURCE_TRACKING, it also carries the record
+// of the acquisition in the resource_tracker, if it was sampled:
+//
+struct lifetime_probe {
+    template< typename T >
+    void acquired () noexcept {
+        std::uint64_t n;
+
+        stats_update< T > ([&] (stats_counters& c) {
+            n = stats_counters::increment (c.acquisitions);
+        });
+
+        stamp_ = 0 == n % UNIQUE_RESOURCE_INSTRUMENTATION_PERIOD ? now () : untimed;
+
+#if defined (UNIQUE_RESOURCE_TRACKING)
+        track_ = resource_tracker::instance ().acquired (stats_type_name< T > (), n);
+#endif // UNIQUE_RESOURCE_TRACKING
+    }
+
+    //
+    // The resource is no longer held, leaked if given away by release ():
+    //
+    template< typename T >
+    void released (bool leaked = false) noexcept {
+        if (stamp_)
+            released< T > (leaked, untimed == stamp_ ? 0 : now ());
+    }
+
+    template< typename T, typename F, typename ...Args >
+    void invoke (F&& f, Args&&... args)
+        noexcept (noexcept (std::forward< F > (f)(std::forward< Args > (args)...))) {
+        if (untimed == stamp_) {
+            std::forward< F > (f)(std::forward< Args > (args)...);
+
+            stats_update< T > ([] (stats_counters& c) {
+                stats_counters::increment (c.invocations);
+            });
+
+            released< T > (false, 0);
+        }
+        else {
+            const auto t0 = now ();
+
+            std::forward< F > (f)(std::forward< Args > (args)...);
+
+            const auto t1 = now ();
+
+            stats_update< T > ([&] (stats_counters& c) {
+                stats_counters::increment (c.invocations);
+                stats_counters::increment (c.latency [stats_counters::bucket (t1 - t0)]);
+            });
+
+            if (stamp_)
+                released< T > (false, t1);
+        }
+    }
+
+    //
+    // One call of a bulk deleter on n resources, already released, counted
+    // as n invocations. The call is always timed, its latency split evenly:
+    //
+    template< typename T, typename F >
+    static void invoke_n (std::size_t n, F&& f)
+        noexcept (noexcept (std::forward< F > (f)())) {
+        const auto t0 = now ();
+
+        std::forward< F > (f)();
+
+        const auto t1 = now ();
+
+        stats_update< T > ([&] (stats_counters& c) {
+            stats_counters::increment (c.invocations, n);
+            stats_counters::increment (
+                c.latency [stats_counters::bucket ((t1 - t0) / n)], n);
+        });
+    }
+
+    //
+    // Takes over the resource of another object. If that is of another type,
+    // the resource moves from the statistics of one type to the other:
+    //
+    template< typename T, typename U >
+    void adopt (lifetime_probe& other) noexcept {
+        if constexpr (std::is_same_v< T, U >) {
+            stamp_ = std::exchange (other.stamp_, 0);
+
+#if defined (UNIQUE_RESOURCE_TRACKING)
+            track_ = std::exchange (other.track_, 0);
+#endif // UNIQUE_RESOURCE_TRACKING
+        }
+        else if (other.stamp_) {
+            other.released< U > ();
+            acquired< T > ();
+        }
+    }
+
+    void swap (lifetime_probe& other) noexcept {
+        std::swap (stamp_, other.stamp_);
+
+#if defined (UNIQUE_RESOURCE_TRACKING)
+        std::swap (track_, other.track_);
+#endif // UNIQUE_RESOURCE_TRACKING
+    }
+
+private:
+    static constexpr std::uint64_t untimed = 1;
+
+    template< typename T >
+    void released (bool leaked, std::uint64_t t) noexcept {
+        stats_update< T > ([&] (stats_counters& c) {
+            stats_counters::increment (c.releases);
+
+            if (untimed != stamp_)
+                stats_counters::increment (c.lifetime [stats_counters::bucket (t - stamp_)]);
+
+            if (leaked)
+                stats_counters::increment (c.leaks);
+        });
+
+        stamp_ = 0;
+
+#if defined (UNIQUE_RESOURCE_TRACKING)
+        if (track_)
+            resource_tracker::instance ().released (
+                std::exchange (track_, 0), leaked);
+#endif // UNIQUE_RESOURCE_TRACKING
+    }
+
+    //
+    // Neither zero nor untimed:
+    //
+    static std::uint64_t now () noexcept {
+        return stats_clock::now () | 2;
+    }
+
+    std::uint64_t stamp_ = 0;
+
+#if defined (UNIQUE_RESOURCE_TRACKING)
+    resource_tracker::handle track_ = 0;
+#endif // UNIQUE_RESOURCE_TRACKING
+};
+
+} // namespace detail
+
+//
+// The statistics of every instrumented type used so far, summed over all
+// threads, live and exited. Counters are read without stopping the threads
+// that update them, a snapshot is not an atomic view of all of them:
+//
+inline std::vector< resource_stats > resource_stats_snapshot () {
+    std::vector< resource_stats > v;
+
+    auto p = detail::stats_registry::instance ().head.load ();
+
+    for (; p; p = p->next) {
+        std::lock_guard< std::mutex > lock (p->mutex);
+
+        resource_stats s = p->retired;
+        s.type = std::string (detail::type_name_of (p->name));
+
+        for (auto q : p->threads)
+            q->add_to (s);
+
+        v.push_back (std::move (s));
+    }
+
+    return v;
+}
+
+}}
+
+#endif // STD_RESOURCE_STATS_HPP
@@ -0,0 +1,301 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_RESOURCE_TRACKER_HPP
+#define STD_RESOURCE_TRACKER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <execinfo.h>
+
+//
+// One acquisition in UNIQUE_RESOURCE_TRACKING_PERIOD is tracked, in a table
+// of UNIQUE_RESOURCE_TRACKING_CAPACITY records, each with the innermost
+// UNIQUE_RESOURCE_TRACKING_DEPTH frames of the acquiring stack:
+//
+#if !defined (UNIQUE_RESOURCE_TRACKING_PERIOD)
+#  define UNIQUE_RESOURCE_TRACKING_PERIOD 1024
+#endif
+
+#if !defined (UNIQUE_RESOURCE_TRACKING_CAPACITY)
+#  define UNIQUE_RESOURCE_TRACKING_CAPACITY 4096
+#endif
+
+#if !defined (UNIQUE_RESOURCE_TRACKING_DEPTH)
+#  define UNIQUE_RESOURCE_TRACKING_DEPTH 8
+#endif
+
+namespace std {
+namespace experimental {
+
+//
+// Sampled acquisitions of unique_resource and scope_guard types, collected
+// when UNIQUE_RESOURCE_TRACKING is defined (in all translation units), with
+// the stack that acquired them. The records form a ring, written lock-free
+// by the acquiring threads; records of live resources are skipped, not
+// overwritten, so the ring keeps the long-lived ones and forms the live set.
+// Resources given away by release () stay as leaked until overwritten.
+//
+struct resource_tracker {
+    static constexpr std::size_t capacity = UNIQUE_RESOURCE_TRACKING_CAPACITY;
+    static constexpr std::size_t depth = UNIQUE_RESOURCE_TRACKING_DEPTH;
+
+    //
+    // A tracked record, its index plus one and its generation; zero for
+    // none:
+    //
+    using handle = std::uint64_t;
+
+private:
+    enum : std::uint64_t {
+        free_state, live_state, released_state, leaked_state, writing_state
+    };
+
+    static constexpr std::uint64_t state_bits = 8;
+    static constexpr std::uint64_t state_mask = (1U << state_bits) - 1;
+
+    //
+    // The fields are written between the writing and the live state; the
+    // dump reads them between two loads of the same word:
+    //
+    struct record {
+        std::atomic< std::uint64_t > word{ 0 };
+
+        std::atomic< const char* > type{ nullptr };
+        std::atomic< std::uint64_t > time{ 0 };
+        std::atomic< std::size_t > frames{ 0 };
+        std::atomic< void* > frame [depth] = { };
+    };
+
+    struct sample {
+        const char* type;
+        std::uint64_t time;
+        bool leaked;
+        std::vector< void* > frames;
+    };
+
+    resource_tracker () = default;
+
+public:
+    resource_tracker (const resource_tracker&) = delete;
+    resource_tracker& operator= (const resource_tracker&) = delete;
+
+    //
+    // Records an acquisition of a resource of the named type if n, its
+    // acquisition count, falls on the sampling period:
+    //
+    handle acquired (const char* type, std::uint64_t n) noexcept {
+        if (0 != n % UNIQUE_RESOURCE_TRACKING_PERIOD)
+            return 0;
+
+        void* frames [depth + 1];
+        const int size = capture (frames, depth + 1);
+
+        //
+        // A few attempts at a record that is not live:
+        //
+        for (int attempts = 0; attempts < 16; ++attempts) {
+            const auto i = head_.fetch_add (1, std::memory_order_relaxed) % capacity;
+            auto& r = records_ [i];
+
+            auto w = r.word.load (std::memory_order_relaxed);
+            const auto state = w & state_mask;
+
+            if (live_state == state || writing_state == state)
+                continue;
+
+            const auto generation = (w >> state_bits) + 1;
+
+            if (!r.word.compare_exchange_strong (
+                    w, generation << state_bits | writing_state,
+                    std::memory_order_acquire))
+                continue;
+
+            //
+            // Without the capturing function:
+            //
+            const std::size_t n = size > 1 ? size - 1 : 0;
+
+            r.type.store (type, std::memory_order_relaxed);
+            r.time.store (now (), std::memory_order_relaxed);
+            r.frames.store (n, std::memory_order_relaxed);
+
+            for (std::size_t j = 0; j < n; ++j)
+                r.frame [j].store (frames [j + 1], std::memory_order_relaxed);
+
+            r.word.store (generation << state_bits | live_state,
+                          std::memory_order_release);
+
+            return (handle (i + 1) << 32) | (generation & 0xFFFFFFFF);
+        }
+
+        dropped_.fetch_add (1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    void released (handle h, bool leaked) noexcept {
+        auto& r = records_ [(h >> 32) - 1];
+
+        auto w = r.word.load (std::memory_order_relaxed);
+        const auto state = leaked ? leaked_state : released_state;
+
+        if (live_state == (w & state_mask) &&
+            (h & 0xFFFFFFFF) == ((w >> state_bits) & 0xFFFFFFFF))
+            r.word.compare_exchange_strong (
+                w, (w & ~state_mask) | state, std::memory_order_relaxed);
+    }
+
+    //
+    // Writes the live and leaked resources, grouped by acquiring stack, the
+    // groups with the oldest resource first, at most sites of them:
+    //
+    void dump (std::ostream& s, std::size_t sites = 16) const {
+        const auto v = samples ();
+        const auto t = now ();
+
+        struct group {
+            const char* type;
+            std::uint64_t oldest;
+            std::size_t live, leaked;
+        };
+
+        std::map< std::vector< void* >, group > m;
+
+        for (const auto& x : v) {
+            auto p = m.emplace (x.frames, group { x.type, x.time, 0, 0 }).first;
+
+            auto& g = p->second;
+            g.oldest = (std::min) (g.oldest, x.time);
+
+            ++(x.leaked ? g.leaked : g.live);
+        }
+
+        std::vector< decltype (m)::const_iterator > w;
+
+        for (auto i = m.begin (); i != m.end (); ++i)
+            w.push_back (i);
+
+        std::sort (w.begin (), w.end (), [](auto a, auto b) {
+            return a->second.oldest < b->second.oldest;
+        });
+
+        std::size_t live = 0;
+
+        for (const auto& x : v)
+            live += !x.leaked;
+
+        s << "resource_tracker: " << live << " live, " << v.size () - live
+          << " leaked, sampling 1 in " << UNIQUE_RESOURCE_TRACKING_PERIOD
+          << ", " << dropped_.load (std::memory_order_relaxed)
+          << " dropped\n";
+
+        for (std::size_t i = 0; i < w.size () && i < sites; ++i) {
+            const auto& frames = w [i]->first;
+            const auto& g = w [i]->second;
+
+            s << "\n#" << i << ": " << g.live << " live, " << g.leaked
+              << " leaked, oldest " << double (t - g.oldest) / 1e9 << " s, "
+              << detail::type_name_of (g.type ? g.type : "") << "\n";
+
+            std::unique_ptr< char*, void(*)(void*) > names (
+                backtrace_symbols (
+                    frames.data (), static_cast< int > (frames.size ())),
+                &std::free);
+
+            for (std::size_t j = 0; j < frames.size (); ++j) {
+                s << "    ";
+
+                if (names)
+                    s << names.get () [j];
+                else
+                    s << frames [j];
+
+                s << "\n";
+            }
+        }
+    }
+
+    //
+    // Dumps to stderr at exit:
+    //
+    static void dump_at_exit () noexcept {
+        instance ();
+
+        std::atexit ([] {
+            instance ().dump (std::cerr);
+        });
+    }
+
+    static resource_tracker& instance () noexcept {
+        static resource_tracker x;
+        return x;
+    }
+
+private:
+    __attribute__ ((noinline))
+    static int capture (void** frames, int size) noexcept {
+        return backtrace (frames, size);
+    }
+
+    static std::uint64_t now () noexcept {
+        using namespace std::chrono;
+
+        const auto t = steady_clock::now ().time_since_epoch ();
+        return duration_cast< nanoseconds > (t).count ();
+    }
+
+    std::vector< sample > samples () const {
+        std::vector< sample > v;
+
+        for (const auto& r : records_) {
+            const auto w = r.word.load (std::memory_order_acquire);
+            const auto state = w & state_mask;
+
+            if (live_state != state && leaked_state != state)
+                continue;
+
+            sample x {
+                r.type.load (std::memory_order_relaxed),
+                r.time.load (std::memory_order_relaxed),
+                leaked_state == state, { } };
+
+            const auto n = (std::min) (
+                r.frames.load (std::memory_order_relaxed), depth);
+
+            for (std::size_t j = 0; j < n; ++j)
+                x.frames.push_back (r.frame [j].load (std::memory_order_relaxed));
+
+            std::atomic_thread_fence (std::memory_order_acquire);
+
+            //
+            // Overwritten meanwhile, or released: the record is not
+            // reported, or reported as it was when read:
+            //
+            const auto u = r.word.load (std::memory_order_relaxed);
+
+            if ((u >> state_bits) == (w >> state_bits))
+                v.push_back (std::move (x));
+        }
+
+        return v;
+    }
+
+private:
+    record records_ [capacity];
+
+    std::atomic< std::uint64_t > head_{ 0 };
+    std::atomic< std::uint64_t > dropped_{ 0 };
+};
+
+}}
+
+#endif // STD_RESOURCE_TRACKER_HPP
@@ -0,0 +1,330 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_SHARED_RESOURCE_HPP
+#define STD_SHARED_RESOURCE_HPP
+
+#include <unique_resource.hh>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace std {
+namespace experimental {
+
+//
+// Reference count policies for shared_resource. A policy starts at one and
+// release () returns true when the last reference is gone.
+//
+struct atomic_refcount {
+    void acquire () noexcept {
+        count_.fetch_add (1, std::memory_order_relaxed);
+    }
+
+    bool release () noexcept {
+        return 1 == count_.fetch_sub (1, std::memory_order_acq_rel);
+    }
+
+    long use_count () const noexcept {
+        return count_.load (std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic< long > count_{ 1 };
+};
+
+//
+// Biased reference counting (Choi, Shull, Torrellas, PACT 2018). The thread
+// that creates the resource counts its own references without atomic
+// read-modify-writes; other threads use an atomic shared counter. A shared
+// counter that goes negative means the owner holds references other threads
+// have released, and the object is queued to the owner, which merges both
+// counters on its next release or at thread exit. Merged objects, and all
+// objects of exited owners, are plain atomically counted objects.
+//
+struct biased_refcount;
+
+namespace detail {
+
+//
+// The objects queued to an owner thread, a lock-free stack:
+//
+struct biased_queue {
+    void push (biased_refcount* p) noexcept;
+    void drain () noexcept;
+
+    std::atomic< biased_refcount* > head{ nullptr };
+    std::atomic< bool > alive{ true };
+};
+
+struct biased_thread {
+    ~biased_thread () {
+        queue->alive.store (false);
+        queue->drain ();
+    }
+
+    const std::shared_ptr< biased_queue > queue = std::make_shared< biased_queue > ();
+};
+
+inline biased_thread& this_biased_thread () {
+    static thread_local biased_thread x;
+    return x;
+}
+
+} // namespace detail
+
+struct biased_refcount {
+    biased_refcount ()
+        : queue_ (detail::this_biased_thread ().queue)
+        { }
+
+    biased_refcount (const biased_refcount&) = delete;
+    biased_refcount& operator= (const biased_refcount&) = delete;
+
+    virtual ~biased_refcount () = default;
+
+    void acquire () noexcept {
+        if (is_owner ())
+            biased_.store (
+                biased_.load (std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        else
+            shared_.fetch_add (one);
+    }
+
+    bool release () noexcept {
+        if (is_owner ()) {
+            queue_->drain ();
+
+            if (!merged_.load (std::memory_order_relaxed)) {
+                const auto n = biased_.load (std::memory_order_relaxed) - 1;
+                biased_.store (n, std::memory_order_relaxed);
+
+                if (n)
+                    return false;
+
+                merged_.store (true, std::memory_order_relaxed);
+                return 0 == shared_.fetch_or (merged);
+            }
+        }
+
+        const auto n = shared_.fetch_sub (one) - one;
+
+        if (merged == n)
+            return true;
+
+        if (0 == (n & (merged | queued)) && count (n) < 0 &&
+            0 == (shared_.fetch_or (queued) & queued))
+            queue_->push (this);
+
+        return false;
+    }
+
+    long use_count () const noexcept {
+        return biased_.load (std::memory_order_relaxed) +
+            count (shared_.load (std::memory_order_relaxed));
+    }
+
+private:
+    friend struct detail::biased_queue;
+
+    static constexpr long merged = 1, queued = 2, one = 4;
+
+    static constexpr long count (long n) noexcept {
+        return (n - (n & 3)) / one;
+    }
+
+    bool is_owner () const noexcept {
+        return queue_ == detail::this_biased_thread ().queue &&
+            !merged_.load (std::memory_order_relaxed);
+    }
+
+    //
+    // Folds the biased count into the shared one and returns true if no
+    // references are left. Runs on the owner thread, or on any thread once
+    // the owner has exited:
+    //
+    bool merge () noexcept {
+        long delta = -queued;
+
+        if (!merged_.load (std::memory_order_relaxed)) {
+            delta += merged + one * biased_.exchange (0, std::memory_order_relaxed);
+            merged_.store (true, std::memory_order_relaxed);
+        }
+
+        return merged == shared_.fetch_add (delta) + delta;
+    }
+
+private:
+    const std::shared_ptr< detail::biased_queue > queue_;
+    biased_refcount* next_ = nullptr;
+
+    //
+    // Only written by the owner thread, or after it has exited:
+    //
+    std::atomic< long > biased_{ 1 };
+    std::atomic< bool > merged_{ false };
+
+    //
+    // References in the high bits, merged and queued flags in the low ones:
+    //
+    std::atomic< long > shared_{ 0 };
+};
+
+namespace detail {
+
+//
+// Once the owner is gone, whoever pushes drains the queue; with both sides
+// sequentially consistent, one of them sees the other:
+//
+inline void biased_queue::push (biased_refcount* p) noexcept {
+    p->next_ = head.load ();
+    while (!head.compare_exchange_weak (p->next_, p)) ;
+
+    if (!alive.load ())
+        drain ();
+}
+
+//
+// The early exit is the load of that handshake, sequentially consistent too:
+//
+inline void biased_queue::drain () noexcept {
+    if (0 == head.load ())
+        return;
+
+    for (biased_refcount* p = head.exchange (nullptr), *next; p; p = next) {
+        next = p->next_;
+
+        if (p->merge ())
+            delete p;
+    }
+}
+
+} // namespace detail
+
+namespace detail {
+
+//
+// The single allocation behind a shared_resource:
+//
+template< typename R, typename D, typename C >
+struct shared_control : C {
+    explicit shared_control (unique_resource< R, D >&& r)
+        : resource (std::move (r))
+        { }
+
+    unique_resource< R, D > resource;
+};
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Shared ownership of a resource: the deleter runs once the last copy goes
+// away. The reference count and the unique_resource share one allocation.
+//
+template< typename R, typename D, typename C = atomic_refcount >
+struct shared_resource {
+private:
+    using control_type = detail::shared_control< R, D, C >;
+
+    template< typename, typename, typename >
+    friend struct shared_resource;
+
+public:
+    shared_resource () noexcept = default;
+
+    explicit shared_resource (unique_resource< R, D >&& r)
+        : control_ (new control_type (std::move (r)))
+        { }
+
+    shared_resource (const shared_resource& other) noexcept
+        : control_ (other.control_) {
+        if (control_)
+            control_->acquire ();
+    }
+
+    shared_resource (shared_resource&& other) noexcept
+        : control_ (std::exchange (other.control_, nullptr))
+        { }
+
+    shared_resource& operator= (shared_resource other) noexcept {
+        swap (other);
+        return *this;
+    }
+
+    ~shared_resource () {
+        reset ();
+    }
+
+    void reset () noexcept {
+        if (control_ && control_->release ())
+            delete control_;
+
+        control_ = nullptr;
+    }
+
+    void swap (shared_resource& other) noexcept {
+        std::swap (control_, other.control_);
+    }
+
+    long use_count () const noexcept {
+        return control_ ? control_->use_count () : 0;
+    }
+
+    explicit operator bool () const noexcept {
+        return control_;
+    }
+
+    const R& get () const noexcept {
+        return control_->resource.get ();
+    }
+
+    operator const R& () const noexcept {
+        return get ();
+    }
+
+    R operator-> () const noexcept {
+        return get ();
+    }
+
+    const D& get_deleter () const noexcept {
+        return control_->resource.get_deleter ();
+    }
+
+private:
+    control_type* control_ = nullptr;
+};
+
+template< typename R, typename D, typename C >
+void swap (shared_resource< R, D, C >& lhs, shared_resource< R, D, C >& rhs) noexcept {
+    lhs.swap (rhs);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// The resource is wrapped in a unique_resource first, so that it is released
+// if the control block cannot be allocated:
+//
+template< typename C = atomic_refcount, typename T, typename U >
+shared_resource< std::decay_t< T >, std::decay_t< U >, C >
+make_shared_resource (T&& t, U&& u) {
+    return shared_resource< std::decay_t< T >, std::decay_t< U >, C > (
+        unique_resource< std::decay_t< T >, std::decay_t< U > > (
+            std::forward< T > (t), std::forward< U > (u)));
+}
+
+template< typename C = atomic_refcount, class T, class U, class S = std::decay_t< T > >
+shared_resource< std::decay_t< T >, std::decay_t< U >, C >
+make_shared_resource_checked (T&& t, const S& s, U&& u) {
+    return shared_resource< std::decay_t< T >, std::decay_t< U >, C > (
+        make_unique_resource_checked (
+            std::forward< T > (t), s, std::forward< U > (u)));
+}
+
+}}
+
+#endif // STD_SHARED_RESOURCE_HPP
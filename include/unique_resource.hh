@@ -8,12 +8,199 @@
 #ifndef STD_UNIQUE_RESOURCE_HPP
 #define STD_UNIQUE_RESOURCE_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <string_view>
 #include <utility>
 
+//
+// Members of empty type (stateless deleters, lambdas without captures) take
+// no storage when the compiler honours [[no_unique_address]]:
+//
+#if defined (__has_cpp_attribute)
+#  if __has_cpp_attribute (no_unique_address)
+#    define UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#  endif
+#endif
+
+#if !defined (UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS)
+#  define UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS
+#endif
+
+//
+// Exception-free configuration, when compiling with -fno-exceptions or with
+// UNIQUE_RESOURCE_NO_EXCEPTIONS defined. The API is the same; scope_fail and
+// scope_success guards cannot observe exceptions and become explicit-commit
+// guards instead: they execute unless released.
+//
+// All translation units of a program must agree on the mode, the templates
+// with a rollback path being defined differently in each. The policies and
+// helpers that depend on it, and make_scope_fail and make_scope_success, are
+// moreover in an inline namespace named after the mode, so that a mismatch
+// does not swap the behaviour of the guards between translation units:
+//
+#if !defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+#  if !defined (__cpp_exceptions) && !defined (__EXCEPTIONS)
+#    define UNIQUE_RESOURCE_NO_EXCEPTIONS 1
+#  endif
+#endif
+
+#if defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+#  define UNIQUE_RESOURCE_TRY      if (true)
+#  define UNIQUE_RESOURCE_CATCH(X) if (false)
+#  define UNIQUE_RESOURCE_EXCEPTION_MODE no_exceptions
+#else
+#  define UNIQUE_RESOURCE_TRY      try
+#  define UNIQUE_RESOURCE_CATCH(X) catch (X)
+#  define UNIQUE_RESOURCE_EXCEPTION_MODE exceptions
+#endif
+
+//
+// Lifetime statistics of unique_resource and scope_guard types, see
+// resource_stats.hh. Must be defined in all translation units or none; when
+// it is not, the probes are empty and compile to nothing. The tracking of
+// live and leaked resources, see resource_tracker.hh, rides on the same
+// probes:
+//
+#if defined (UNIQUE_RESOURCE_TRACKING) && !defined (UNIQUE_RESOURCE_INSTRUMENTATION)
+#  define UNIQUE_RESOURCE_INSTRUMENTATION
+#endif
+
+namespace std {
+namespace experimental {
+namespace detail {
+
+//
+// The type out of a compiler function signature of a template of parameter
+// T (e.g., __PRETTY_FUNCTION__), for the statistics, the tracker and the
+// USDT probes; the whole signature if there is none:
+//
+constexpr std::string_view type_name_of (std::string_view s) noexcept {
+    const auto first = s.find ("T = ");
+    const auto last = s.find_first_of (";]", first);
+
+    if (std::string_view::npos == first || std::string_view::npos == last)
+        return s;
+
+    return s.substr (first + 4, last - first - 4);
+}
+
+} // namespace detail
+}}
+
+#if defined (UNIQUE_RESOURCE_INSTRUMENTATION)
+#  include <resource_stats.hh>
+#endif
+
+//
+// USDT probes for perf and bpftrace (see examples/*.bt) when compiled with
+// UNIQUE_RESOURCE_USDT defined, provider unique_resource:
+//
+//   acquire, reset_value, release, destroy, delete_begin, delete_end
+//       (resource, type, "flag" or "sentinel")
+//   guard_begin, guard_end
+//       (guard address, type, policy type, executed)
+//
+// The resource is its value if integral or a pointer, its address otherwise;
+// types are C strings. A probe is a nop in the code, plus the setup of its
+// arguments; without UNIQUE_RESOURCE_USDT there is nothing at all.
+//
+#if defined (UNIQUE_RESOURCE_USDT)
+#  include <sys/sdt.h>
+#  include <array>
+#  include <cstdint>
+#  define UNIQUE_RESOURCE_TRACE_RESOURCE(name, r)                            \
+    DTRACE_PROBE3 (unique_resource, name,                                   \
+        ::std::experimental::detail::trace_value (r),                       \
+        ::std::experimental::detail::trace_tag< unique_resource >.data (),  \
+        has_invalid_v ? "sentinel" : "flag")
+#  define UNIQUE_RESOURCE_TRACE_GUARD(name, b)                               \
+    DTRACE_PROBE4 (unique_resource, name, this,                             \
+        ::std::experimental::detail::trace_tag< F >.data (),                \
+        ::std::experimental::detail::trace_tag< P >.data (), int (b))
+#else
+#  define UNIQUE_RESOURCE_TRACE_RESOURCE(name, r) ((void) 0)
+#  define UNIQUE_RESOURCE_TRACE_GUARD(name, b)    ((void) 0)
+#endif // UNIQUE_RESOURCE_USDT
+
 namespace std {
 namespace experimental {
+
+//
+// Fast process teardown. After begin_process_teardown (), the destructors of
+// unique_resource and scope_exit guards no longer call the deleters and the
+// functions that are skippable at teardown, leaving what the kernel reclaims
+// at exit anyway (memory, descriptors, mappings) to it. Neither reset (),
+// nor the other scope guards are affected.
+//
+// A deleter or a function is skippable if it declares a static
+// `skip_at_teardown' member set to true, or is wrapped by
+// skipped_at_teardown (). With UNIQUE_RESOURCE_FAST_SHUTDOWN defined (in all
+// translation units or none), all of them are, except for the allow-listed
+// ones that declare it false or are wrapped by kept_at_teardown () (e.g.,
+// flushing a file, removing a temporary one). May also be specialized. Only
+// the destructors of skippable types check the flag, with a relaxed load:
+//
+template< typename D, typename = void >
+struct teardown_traits {
+#if defined (UNIQUE_RESOURCE_FAST_SHUTDOWN)
+    static constexpr bool value = true;
+#else
+    static constexpr bool value = false;
+#endif // UNIQUE_RESOURCE_FAST_SHUTDOWN
+};
+
+template< typename D >
+struct teardown_traits<
+    D, std::void_t< decltype (std::decay_t< D >::skip_at_teardown) > > {
+    static constexpr bool value = std::decay_t< D >::skip_at_teardown;
+};
+
+namespace detail {
+
+inline std::atomic< bool > process_teardown{ false };
+
+} // namespace detail
+
+//
+// Irreversible, to be called once the process is about to exit:
+//
+inline void begin_process_teardown () noexcept {
+    detail::process_teardown.store (true, std::memory_order_relaxed);
+}
+
+inline bool in_process_teardown () noexcept {
+    return detail::process_teardown.load (std::memory_order_relaxed);
+}
+
+template< typename F, bool B >
+struct teardown_function {
+    static constexpr bool skip_at_teardown = B;
+
+    template< typename ...Args >
+    auto operator() (Args&&... args) const
+        noexcept (noexcept (std::declval< const F& > ()(std::forward< Args > (args)...)))
+        -> decltype (std::declval< const F& > ()(std::forward< Args > (args)...)) {
+        return f (std::forward< Args > (args)...);
+    }
+
+    F f;
+};
+
+template< typename F >
+teardown_function< std::decay_t< F >, true > skipped_at_teardown (F&& f) {
+    return { std::forward< F > (f) };
+}
+
+template< typename F >
+teardown_function< std::decay_t< F >, false > kept_at_teardown (F&& f) {
+    return { std::forward< F > (f) };
+}
+
 namespace detail {
 
 template< typename T >
@@ -37,9 +224,18 @@ inline constexpr T& as_const (T& x) noexcept {
     return x;
 }
 
+inline namespace UNIQUE_RESOURCE_EXCEPTION_MODE {
+
+#if defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+template< bool B > inline void rethrow_helper () { std::terminate (); }
+#else
 template< bool B > inline void rethrow_helper () { throw; }
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+
 template< > inline void rethrow_helper< true > () { }
 
+} // inline namespace UNIQUE_RESOURCE_EXCEPTION_MODE
+
 ////////////////////////////////////////////////////////////////////////
 
 struct scope_ignore;
@@ -79,8 +275,13 @@ public:
         return std::move (value);
     }
 
+    void swap (box& other) noexcept (std::is_nothrow_swappable_v< T >) {
+        using std::swap;
+        swap (value, other.value);
+    }
+
 private:
-    T value;
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS T value;
 };
 
 template< typename T >
@@ -104,6 +305,13 @@ public:
         return get ();
     }
 
+    //
+    // Rebinds, as with the reference_wrapper:
+    //
+    void swap (box& other) noexcept {
+        std::swap (value, other.value);
+    }
+
 private:
     std::reference_wrapper< T > value;
 };
@@ -112,6 +320,82 @@ struct scope_ignore {
     void release () noexcept { }
 };
 
+//
+// Ownership flag of a unique_resource; empty when the ownership is encoded in
+// the resource value itself (see invalid_resource_traits):
+//
+template< bool >
+struct ownership_flag {
+    bool value = true;
+};
+
+template< >
+struct ownership_flag< false > { };
+
+#if defined (UNIQUE_RESOURCE_USDT)
+//
+// The probe arguments:
+//
+template< typename R >
+long long trace_value (const R& r) noexcept {
+    if constexpr (std::is_integral_v< R > || std::is_enum_v< R >)
+        return static_cast< long long > (r);
+    else if constexpr (std::is_pointer_v< R >)
+        return static_cast< long long > (reinterpret_cast< std::uintptr_t > (r));
+    else
+        return static_cast< long long > (reinterpret_cast< std::uintptr_t > (&r));
+}
+
+template< typename T >
+constexpr std::string_view trace_type_name () noexcept {
+    return type_name_of (__PRETTY_FUNCTION__);
+}
+
+template< typename T, std::size_t ...I >
+constexpr std::array< char, sizeof... (I) + 1 >
+trace_tag_of (std::index_sequence< I... >) noexcept {
+    return { { trace_type_name< T > () [I]..., 0 } };
+}
+
+template< typename T >
+inline constexpr auto trace_tag = trace_tag_of< T > (
+    std::make_index_sequence< trace_type_name< T > ().size () > { });
+#endif // UNIQUE_RESOURCE_USDT
+
+//
+// The instrumentation hooks, for the statistics of type T:
+//
+struct null_probe {
+    template< typename T >
+    void acquired () noexcept { }
+
+    template< typename T >
+    void released (bool = false) noexcept { }
+
+    template< typename T, typename F, typename ...Args >
+    void invoke (F&& f, Args&&... args)
+        noexcept (noexcept (std::forward< F > (f)(std::forward< Args > (args)...))) {
+        std::forward< F > (f)(std::forward< Args > (args)...);
+    }
+
+    template< typename T, typename F >
+    static void invoke_n (std::size_t, F&& f)
+        noexcept (noexcept (std::forward< F > (f)())) {
+        std::forward< F > (f)();
+    }
+
+    template< typename T, typename U >
+    void adopt (null_probe&) noexcept { }
+
+    void swap (null_probe&) noexcept { }
+};
+
+#if defined (UNIQUE_RESOURCE_INSTRUMENTATION)
+using probe = lifetime_probe;
+#else
+using probe = null_probe;
+#endif // UNIQUE_RESOURCE_INSTRUMENTATION
+
 struct scope_exit_policy {
     bool value = true;
 
@@ -124,27 +408,88 @@ struct scope_exit_policy {
     }
 };
 
+//
+// The guards the library uses internally to undo a failed construction; as
+// scope_exit, but never instrumented:
+//
+struct rollback_policy : scope_exit_policy { };
+
+template< typename P >
+using probe_t = std::conditional_t<
+    std::is_same_v< P, rollback_policy >, null_probe, probe >;
+
+//
+// Whether the destructor of a unique_resource with deleter D, or of a scope
+// guard of policy P with function D, is to skip the call:
+//
+template< typename D, typename P = scope_exit_policy >
+inline bool skips_at_teardown () noexcept {
+    if constexpr (std::is_same_v< P, scope_exit_policy > &&
+                  teardown_traits< D >::value)
+        return in_process_teardown ();
+    else
+        return false;
+}
+
+inline namespace UNIQUE_RESOURCE_EXCEPTION_MODE {
+
+#if defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+//
+// No exception is ever in flight, execute unless released:
+//
+inline int uncaught_exceptions () noexcept {
+    return 0;
+}
+#else
+inline int uncaught_exceptions () noexcept {
+    return std::uncaught_exceptions ();
+}
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+
 struct scope_fail_policy {
-    int value = std::uncaught_exceptions ();
+    int value = detail::uncaught_exceptions ();
 
     void release () noexcept {
         value = std::numeric_limits< int >::max ();
     }
 
     bool should_execute () noexcept {
+#if defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+        return value != std::numeric_limits< int >::max ();
+#else
         return value < std::uncaught_exceptions ();
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
     }
 };
 
 struct scope_success_policy {
-    int value = std::uncaught_exceptions ();
+    int value = detail::uncaught_exceptions ();
 
     void release () noexcept {
         value = -1;
     }
 
     bool should_execute () noexcept {
-        return value >= std::uncaught_exceptions ();
+        return value >= detail::uncaught_exceptions ();
+    }
+};
+
+} // inline namespace UNIQUE_RESOURCE_EXCEPTION_MODE
+
+//
+// Policies bound to an explicit transaction T, which never consult the
+// runtime: B is the committed () state under which the guard executes.
+//
+template< typename T, bool B >
+struct transaction_policy {
+    const T* value = nullptr;
+
+    void release () noexcept {
+        value = nullptr;
+    }
+
+    bool should_execute () noexcept {
+        return value && B == value->committed ();
     }
 };
 
@@ -178,6 +523,16 @@ private:
         return scope_guard< T&, P > (*pf);
     }
 
+    template< typename T >
+    static auto make_guard (std::true_type, T, const P&) {
+        return scope_ignore { };
+    }
+
+    template< typename T >
+    static auto make_guard (std::false_type, T* pf, const P& policy) {
+        return scope_guard< T&, P > (*pf, policy);
+    }
+
 private:
     template< typename FP >
     using is_constructible_from =
@@ -201,20 +556,48 @@ public:
     explicit scope_guard (FP&& p)
         noexcept (is_nothrow_constructible_from_v< FP >)
         : function_ ((FP&&)p, scope_guard::make_guard (
-                         is_nothrow_constructible_from< FP > { }, &p))
-        { }
+                         is_nothrow_constructible_from< FP > { }, &p)) {
+        probe_.template acquired< scope_guard > ();
+    }
+
+    //
+    // With the policy state given instead of default constructed:
+    //
+    template< typename FP,
+              typename = std::enable_if_t< is_constructible_from_v< FP > > >
+    scope_guard (FP&& p, const P& policy)
+        noexcept (is_nothrow_constructible_from_v< FP >)
+        : P (policy), function_ ((FP&&)p, scope_guard::make_guard (
+                         is_nothrow_constructible_from< FP > { }, &p, policy)) {
+        probe_.template acquired< scope_guard > ();
+    }
 
     scope_guard (scope_guard&& other)
         noexcept(noexcept (box< F > (other.function_.move (), other)))
-        : P (other), function_ (other.function_.move (), other)
-        { }
+        : P (other), function_ (other.function_.move (), other) {
+        probe_.template adopt< scope_guard, scope_guard > (other.probe_);
+    }
 
     scope_guard& operator= (scope_guard &&) = delete;
 
     ~scope_guard () noexcept (
         noexcept (std::declval< box< F >& > ().get ()())) {
-        if (P::should_execute ())
-            function_.get ()();
+        if constexpr (std::is_same_v< P, rollback_policy >) {
+            if (P::should_execute ())
+                function_.get ()();
+        }
+        else {
+            const bool b = P::should_execute () && !skips_at_teardown< F, P > ();
+
+            UNIQUE_RESOURCE_TRACE_GUARD (guard_begin, b);
+
+            if (b)
+                probe_.template invoke< scope_guard > (function_.get ());
+            else
+                probe_.template released< scope_guard > ();
+
+            UNIQUE_RESOURCE_TRACE_GUARD (guard_end, b);
+        }
     }
 
     scope_guard (const scope_guard&) = delete;
@@ -222,6 +605,7 @@ public:
 
 private:
     box< F > function_;
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS probe_t< P > probe_;
 };
 
 template< typename F, typename P >
@@ -249,6 +633,17 @@ inline auto make_scope_guard (F&& f) {
     return scope_guard< std::decay_t< F >, P > (std::forward< F > (f));
 }
 
+template< typename F, typename P >
+inline auto make_scope_guard (F&& f, const P& policy) {
+    return scope_guard< std::decay_t< F >, P > (std::forward< F > (f), policy);
+}
+
+template< typename F >
+inline auto make_rollback (F&& f)
+    noexcept (is_nothrow_constructible_v< std::decay_t< F >, F >) {
+    return make_scope_guard< F, rollback_policy > (std::forward< F > (f));
+}
+
 } // namespace detail
 
 ////////////////////////////////////////////////////////////////////////
@@ -260,6 +655,8 @@ auto make_scope_exit (F&& f)
         F, detail::scope_exit_policy > (std::forward< F > (f));
 }
 
+inline namespace UNIQUE_RESOURCE_EXCEPTION_MODE {
+
 template< typename F >
 auto make_scope_fail (F&& f)
     noexcept (detail::is_nothrow_constructible_v< std::decay_t< F >, F >) {
@@ -276,6 +673,80 @@ auto make_scope_success (F&& f)
 
 ////////////////////////////////////////////////////////////////////////
 
+//
+// The exception state at the start of a transaction, captured once and
+// shared by the scope_fail and scope_success guards made from it, which then
+// query the runtime only when they are destroyed. The guards must not
+// outlive the transaction_scope.
+//
+struct transaction_scope {
+    int uncaught_exceptions () const noexcept {
+        return value_;
+    }
+
+private:
+    int value_ = detail::uncaught_exceptions ();
+};
+
+template< typename F >
+auto make_scope_fail (const transaction_scope& t, F&& f)
+    noexcept (detail::is_nothrow_constructible_v< std::decay_t< F >, F >) {
+    return detail::make_scope_guard< F > (
+        std::forward< F > (f),
+        detail::scope_fail_policy { t.uncaught_exceptions () });
+}
+
+template< typename F >
+auto make_scope_success (const transaction_scope& t, F&& f)
+    noexcept (detail::is_nothrow_constructible_v< std::decay_t< F >, F >) {
+    return detail::make_scope_guard< F > (
+        std::forward< F > (f),
+        detail::scope_success_policy { t.uncaught_exceptions () });
+}
+
+} // inline namespace UNIQUE_RESOURCE_EXCEPTION_MODE
+
+//
+// An explicitly committed transaction. scope_fail guards made from it run
+// if it is not committed when they are destroyed, scope_success guards if
+// it is; exceptions are not consulted. Guards must therefore be destroyed
+// after the commit or rollback decision, and not outlive the transaction.
+//
+struct transaction {
+    void commit () noexcept {
+        committed_ = true;
+    }
+
+    void rollback () noexcept {
+        committed_ = false;
+    }
+
+    bool committed () const noexcept {
+        return committed_;
+    }
+
+private:
+    bool committed_ = false;
+};
+
+template< typename F >
+auto make_scope_fail (const transaction& t, F&& f)
+    noexcept (detail::is_nothrow_constructible_v< std::decay_t< F >, F >) {
+    return detail::make_scope_guard< F > (
+        std::forward< F > (f),
+        detail::transaction_policy< transaction, false > { &t });
+}
+
+template< typename F >
+auto make_scope_success (const transaction& t, F&& f)
+    noexcept (detail::is_nothrow_constructible_v< std::decay_t< F >, F >) {
+    return detail::make_scope_guard< F > (
+        std::forward< F > (f),
+        detail::transaction_policy< transaction, true > { &t });
+}
+
+////////////////////////////////////////////////////////////////////////
+
 template< typename T >
 struct null_delete {
     constexpr null_delete() noexcept = default;
@@ -289,6 +760,85 @@ struct null_delete {
 
 ////////////////////////////////////////////////////////////////////////
 
+//
+// A deleter known at compile time, e.g., deleter_constant< &::close >. It is
+// an empty type, never stored, and the call is direct. An optional second
+// argument is the invalid resource value (see invalid_resource_traits):
+//
+template< auto F, auto... >
+struct deleter_constant;
+
+template< auto F >
+struct deleter_constant< F > {
+    static constexpr auto value = F;
+
+    template< typename T >
+    void operator() (T&& t) const noexcept (noexcept (F (std::forward< T > (t)))) {
+        F (std::forward< T > (t));
+    }
+};
+
+template< auto F, auto I >
+struct deleter_constant< F, I > : deleter_constant< F > {
+    static constexpr auto invalid_resource = I;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// A deleter may also accept a contiguous run of resources, d (first, n), to
+// release many of them in one call (e.g., with close_range (2)):
+//
+template< typename D, typename R, typename = void >
+struct is_bulk_deleter : std::false_type { };
+
+template< typename D, typename R >
+struct is_bulk_deleter<
+    D, R, std::void_t< decltype (
+        std::declval< D& > ()(std::declval< R* > (), std::size_t ())) > >
+    : std::true_type { };
+
+template< typename D, typename R >
+constexpr auto is_bulk_deleter_v = is_bulk_deleter< D, R >::value;
+
+namespace detail {
+
+template< typename D, typename R >
+inline void delete_n (D& d, R* first, std::size_t n) noexcept {
+    if constexpr (is_bulk_deleter_v< D, R >)
+        d (first, n);
+    else
+        for (; n; --n, ++first)
+            d (*first);
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Opt-in sentinel for a resource/deleter pair. A deleter that declares a
+// static `invalid_resource' member (e.g., -1 for file descriptors, nullptr for
+// pointers) makes unique_resource track ownership by comparing against it,
+// instead of keeping a separate flag. May also be specialized.
+//
+template< typename R, typename D, typename = void >
+struct invalid_resource_traits {
+    static constexpr bool value = false;
+};
+
+template< typename R, typename D >
+struct invalid_resource_traits<
+    R, D, std::void_t< decltype (std::decay_t< D >::invalid_resource) > > {
+    static constexpr bool value = !std::is_reference_v< R >;
+
+    static constexpr R invalid () noexcept {
+        return std::decay_t< D >::invalid_resource;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////
+
 template< typename R, typename D >
 struct unique_resource {
 private:
@@ -316,14 +866,96 @@ private:
     using enable_member_t = std::enable_if_t<
         is_boxable_resource_v< T > && is_boxable_deleter_v< U > >;
 
+    template< typename T >
+    static constexpr auto is_nothrow_box_swappable_v = noexcept (
+        std::declval< detail::box< T >& > ().swap (
+            std::declval< detail::box< T >& > ()));
+
+    using traits_type = invalid_resource_traits< R, D >;
+    static constexpr bool has_invalid_v = traits_type::value;
+
+    using release_result_t = std::conditional_t<
+        has_invalid_v, R, const R& >;
+
 private:
     template< typename, typename >
     friend struct unique_resource;
 
+    template< typename I >
+    friend void reset_all (I, I) noexcept;
+
     detail::box< R > resource_;
-    detail::box< D > deleter_;
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS detail::box< D > deleter_;
+
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS
+    detail::ownership_flag< !has_invalid_v > execute_on_reset_;
+
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS detail::probe probe_;
+
+private:
+    bool owns () const noexcept {
+        if constexpr (has_invalid_v)
+            return !(get () == traits_type::invalid ());
+        else
+            return execute_on_reset_.value;
+    }
+
+    void disown () noexcept {
+        if constexpr (has_invalid_v)
+            resource_.get () = traits_type::invalid ();
+        else
+            execute_on_reset_.value = false;
+    }
+
+    void own (bool b) noexcept {
+        if constexpr (has_invalid_v) {
+            if (!b)
+                disown ();
+        }
+        else
+            execute_on_reset_.value = b;
+    }
+
+    //
+    // A resource taken over from the same type carries its sentinel along:
+    //
+    template< typename T, typename U >
+    void own_moved (const unique_resource< T, U >&, bool b) noexcept {
+        if constexpr (
+            !has_invalid_v || !std::is_same_v< unique_resource, unique_resource< T, U > >)
+            own (b);
+    }
+
+    template< typename T, typename U >
+    unique_resource (unique_resource< T, U >&& other, bool b)
+        noexcept (
+            noexcept (detail::box< R > (other.resource_.move (), detail::scope_ignore { })) &&
+            noexcept (detail::box< D > (other.deleter_.move (),  detail::scope_ignore { })))
+        : resource_ (other.resource_.move (), detail::scope_ignore { }),
+          deleter_  (other. deleter_.move (), move_guard (other)) {
+        own_moved (other, b);
+        other.disown ();
+        probe_.adopt< unique_resource, unique_resource< T, U > > (other.probe_);
+    }
 
-    bool execute_on_reset_{ true };
+    //
+    // Releases the moved-from resource if moving the deleter throws; nothing
+    // when it cannot, so that a nothrow move is only the member moves:
+    //
+    template< typename T, typename U >
+    auto move_guard (unique_resource< T, U >& other) noexcept {
+        if constexpr (noexcept (detail::box< D > (
+                          other.deleter_.move (), detail::scope_ignore { }))) {
+            return detail::scope_ignore { };
+        }
+        else {
+            return detail::make_rollback ([&other, this] () noexcept {
+                other.probe_.template invoke< unique_resource< T, U > > (
+                    other.get_deleter (), get ());
+                other.disown ();
+            });
+        }
+    }
 
 private:
     unique_resource (const unique_resource&) = delete;
@@ -335,32 +967,38 @@ public:
         noexcept (
             noexcept (detail::box< R > ((R&&)t, detail::scope_ignore { })) &&
             noexcept (detail::box< D > ((D&&)u, detail::scope_ignore { })))
-        : resource_ (std::forward< T > (t), make_scope_exit ([&] { if (b) u (t); })),
-          deleter_  (std::forward< U > (u), make_scope_exit ([&, this] { if (b) u (get ()); })),
-          execute_on_reset_ (b)
-        { }
+        : resource_ (std::forward< T > (t), detail::make_rollback ([&] { if (b) u (t); })),
+          deleter_  (std::forward< U > (u), detail::make_rollback ([&, this] { if (b) u (get ()); })) {
+        own (b);
+
+        if (b) {
+            probe_.acquired< unique_resource > ();
+            UNIQUE_RESOURCE_TRACE_RESOURCE (acquire, get ());
+        }
+    }
 
     template< typename T, typename U, typename = enable_member_t< T, U > >
     explicit unique_resource (T&& t, U&& u)
         noexcept (
             noexcept (detail::box< R > (forward< T > (t), detail::scope_ignore { })) &&
             noexcept (detail::box< D > (forward< U > (u), detail::scope_ignore { })))
-        : resource_ (std::forward< T > (t), make_scope_exit ([&] { u (t); })),
-          deleter_  (std::forward< U > (u), make_scope_exit ([&, this] { u (get ()); }))
-        { }
+        : resource_ (std::forward< T > (t), detail::make_rollback ([&] { u (t); })),
+          deleter_  (std::forward< U > (u), detail::make_rollback ([&, this] { u (get ()); })) {
+        //
+        // A sentinel may hold the invalid value from the start:
+        //
+        if (owns ()) {
+            probe_.acquired< unique_resource > ();
+            UNIQUE_RESOURCE_TRACE_RESOURCE (acquire, get ());
+        }
+    }
 
     template< typename T, typename U, typename = enable_member_t< T, U > >
     unique_resource (unique_resource< T, U >&& other)
         noexcept (
             noexcept (detail::box< R > (other.resource_.move (), detail::scope_ignore { })) &&
             noexcept (detail::box< D > (other.deleter_.move (),  detail::scope_ignore { })))
-        : resource_ (other.resource_.move (), detail::scope_ignore { }),
-          deleter_  (other. deleter_.move (), make_scope_exit (
-              [&, this] () noexcept {
-                  other.get_deleter ()(get ());
-                  other.release ();
-              })),
-          execute_on_reset_ (std::exchange (other.execute_on_reset_, false))
+        : unique_resource (std::move (other), other.owns ())
         { }
 
     template< typename T, typename U, typename = enable_member_t< T, U > >
@@ -370,15 +1008,21 @@ public:
         if (this != &other) {
             reset ();
 
-            if (is_nothrow_move_assignable_v< detail::box< R > >) {
+            const bool b = other.owns ();
+
+            if constexpr (is_nothrow_move_assignable_v< detail::box< R > >) {
                 deleter_  = detail::move_assign_cast (other.deleter_);
                 resource_ = detail::move_assign_cast (other.resource_);
-                execute_on_reset_ = std::exchange (other.execute_on_reset_, false);
+                own_moved (other, b);
+                other.disown ();
+                probe_.adopt< unique_resource, unique_resource< T, U > > (other.probe_);
             }
-            else if (is_nothrow_move_assignable_v< detail::box< D > >) {
+            else if constexpr (is_nothrow_move_assignable_v< detail::box< D > >) {
                 resource_ = detail::move_assign_cast (other.resource_);
                 deleter_  = detail::move_assign_cast (other.deleter_);
-                execute_on_reset_ = std::exchange (other.execute_on_reset_, false);
+                own_moved (other, b);
+                other.disown ();
+                probe_.adopt< unique_resource, unique_resource< T, U > > (other.probe_);
             }
             else {
                 resource_ = detail::as_const (other.resource_);
@@ -387,20 +1031,25 @@ public:
                 // Try to avoid a resource leak, the resource has been assigned
                 // successfully, and the old deleter has lost track of it:
                 //
-                try {
+                UNIQUE_RESOURCE_TRY {
                     deleter_  = detail::as_const (other.deleter_);
-                    execute_on_reset_ = std::exchange (other.execute_on_reset_, false);
+                    own_moved (other, b);
+                    other.disown ();
+                    probe_.adopt< unique_resource, unique_resource< T, U > > (other.probe_);
                 }
-                catch (...) {
+                UNIQUE_RESOURCE_CATCH (...) {
                     //
                     // Release the resource with the old deleter:
                     //
-                    other.get_deleter ()(get ());
+                    if (b)
+                        other.probe_.template invoke< unique_resource< T, U > > (
+                            other.get_deleter (), get ());
 
                     //
                     // Deactivate all deleters:
                     //
-                    execute_on_reset_ = other.execute_on_reset_ = false;
+                    disown ();
+                    other.disown ();
 
                     //
                     // And re-throw matching the function type:
@@ -416,14 +1065,49 @@ public:
     }
 
     ~unique_resource () noexcept {
-        reset ();
+        UNIQUE_RESOURCE_TRACE_RESOURCE (destroy, get ());
+
+        if (detail::skips_at_teardown< D > ())
+            probe_.released< unique_resource > ();
+        else
+            reset ();
+    }
+
+    //
+    // Strong guarantee if swapping R or D cannot throw, basic otherwise:
+    //
+    void swap (unique_resource& other) noexcept (
+        is_nothrow_box_swappable_v< R > && is_nothrow_box_swappable_v< D >) {
+        if constexpr (is_nothrow_box_swappable_v< R >) {
+            deleter_.swap (other.deleter_);
+            resource_.swap (other.resource_);
+        }
+        else {
+            resource_.swap (other.resource_);
+            deleter_.swap (other.deleter_);
+        }
+
+        if constexpr (!has_invalid_v)
+            std::swap (execute_on_reset_, other.execute_on_reset_);
+
+        probe_.swap (other.probe_);
     }
 
     void
     reset () noexcept {
-        if (execute_on_reset_) {
-            execute_on_reset_ = false;
-            get_deleter ()(get ());
+        if (owns ()) {
+            UNIQUE_RESOURCE_TRACE_RESOURCE (delete_begin, get ());
+
+            if constexpr (has_invalid_v) {
+                probe_.invoke< unique_resource > (get_deleter (), get ());
+                UNIQUE_RESOURCE_TRACE_RESOURCE (delete_end, get ());
+                disown ();
+            }
+            else {
+                disown ();
+                probe_.invoke< unique_resource > (get_deleter (), get ());
+                UNIQUE_RESOURCE_TRACE_RESOURCE (delete_end, get ());
+            }
         }
     }
 
@@ -431,14 +1115,50 @@ public:
     reset (R&& r) noexcept (noexcept (detail::box< R > (std::move (r)))) {
         reset ();
         resource_ = std::move (r);
-        execute_on_reset_ = true;
+        own (true);
+
+        if (owns ()) {
+            probe_.acquired< unique_resource > ();
+            UNIQUE_RESOURCE_TRACE_RESOURCE (reset_value, get ());
+        }
     }
 
-    const R& release () noexcept {
-        execute_on_reset_ = false;
-        return get ();
+    //
+    // With a sentinel the released value is returned by copy, the resource
+    // itself is reset to the invalid value:
+    //
+    release_result_t release () noexcept {
+        probe_.released< unique_resource > (true);
+        UNIQUE_RESOURCE_TRACE_RESOURCE (release, get ());
+
+        if constexpr (has_invalid_v) {
+            R r = get ();
+            disown ();
+            return r;
+        }
+        else {
+            disown ();
+            return get ();
+        }
+    }
+
+private:
+    //
+    // A call of a bulk deleter for reset_all (), on resources no longer
+    // owned, one invocation each:
+    //
+    template< typename T >
+    static void delete_batch (D& d, T* first, std::size_t n) noexcept {
+        for (std::size_t i = 0; i < n; ++i)
+            UNIQUE_RESOURCE_TRACE_RESOURCE (delete_begin, first [i]);
+
+        detail::probe::invoke_n< unique_resource > (n, [&] { d (first, n); });
+
+        for (std::size_t i = 0; i < n; ++i)
+            UNIQUE_RESOURCE_TRACE_RESOURCE (delete_end, first [i]);
     }
 
+public:
     R& get () noexcept {
         return resource_.get ();
     }
@@ -470,6 +1190,12 @@ public:
     }
 };
 
+template< typename R, typename D >
+void swap (unique_resource< R, D >& lhs, unique_resource< R, D >& rhs)
+    noexcept (noexcept (lhs.swap (rhs))) {
+    lhs.swap (rhs);
+}
+
 template< typename T, typename U >
 auto make_unique_resource (T&& t, U&& u) noexcept (
     noexcept (unique_resource< T, U > (
@@ -490,6 +1216,75 @@ make_unique_resource_checked (T&& t, const S& s, U&& u)
         std::forward< T > (t), std::forward< U > (u), b };
 }
 
+////////////////////////////////////////////////////////////////////////
+
+template< typename R, auto F, auto... I >
+using static_unique_resource = unique_resource< R, deleter_constant< F, I... > >;
+
+template< auto F, typename T >
+static_unique_resource< std::decay_t< T >, F >
+make_unique_resource (T&& t)
+    noexcept (is_nothrow_constructible_v< std::decay_t< T >, T >) {
+    return static_unique_resource< std::decay_t< T >, F > (
+        std::forward< T > (t), deleter_constant< F > { });
+}
+
+template< auto F, class T, class S = std::decay_t< T > >
+static_unique_resource< std::decay_t< T >, F >
+make_unique_resource_checked (T&& t, const S& s)
+    noexcept (is_nothrow_constructible_v< std::decay_t< T >, T >) {
+    bool b = t != s;
+    return static_unique_resource< std::decay_t< T >, F > (
+        std::forward< T > (t), deleter_constant< F > { }, b);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// Resets a range of unique_resource objects. A stateless bulk deleter is
+// handed the owned resources in batches instead of one call per object:
+//
+template< typename I >
+void reset_all (I first, I last) noexcept {
+    using T = typename std::iterator_traits< I >::value_type;
+
+    using R = std::remove_cv_t< std::remove_reference_t<
+        decltype (std::declval< T& > ().get ()) > >;
+
+    using D = std::remove_reference_t<
+        decltype (std::declval< T& > ().get_deleter ()) >;
+
+    if constexpr (
+        is_bulk_deleter_v< D, R > && std::is_empty_v< D > &&
+        std::is_trivial_v< R >) {
+        static constexpr std::size_t N = 64;
+
+        R buf [N];
+        std::size_t n = 0;
+
+        D* d = nullptr;
+
+        for (; first != last; ++first) {
+            if (first->owns ()) {
+                d = &first->get_deleter ();
+                first->probe_.template released< T > ();
+                buf [n++] = first->get ();
+                first->disown ();
+
+                if (N == n)
+                    T::delete_batch (*d, buf, std::exchange (n, 0));
+            }
+        }
+
+        if (n)
+            T::delete_batch (*d, buf, n);
+    }
+    else {
+        for (; first != last; ++first)
+            first->reset ();
+    }
+}
+
 }}
 
 #endif // STD_UNIQUE_RESOURCE_HPP
@@ -0,0 +1,435 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_UNIQUE_RESOURCE_VECTOR_HPP
+#define STD_UNIQUE_RESOURCE_VECTOR_HPP
+
+#include <unique_resource.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace std {
+namespace experimental {
+namespace detail {
+
+inline unsigned countr_zero (std::uint64_t x) noexcept {
+#if defined (__GNUC__)
+    return __builtin_ctzll (x);
+#else
+    unsigned n = 0;
+    for (; 0 == (x & 1); x >>= 1, ++n) ;
+    return n;
+#endif // __GNUC__
+}
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// A structure-of-arrays counterpart of std::vector< unique_resource< R, D > >:
+// handles are contiguous, the deleter is stored once, and ownership is one
+// bit per element.
+//
+template< typename R, typename D >
+struct unique_resource_vector {
+    using value_type = R;
+    using deleter_type = D;
+    using size_type = std::size_t;
+
+    static_assert (!std::is_reference_v< R >, "resource must not be a reference");
+
+    static_assert (
+        std::is_nothrow_move_constructible_v< D >,
+        "deleter must be nothrow_move_constructible");
+
+private:
+    using word_type = std::uint64_t;
+    static constexpr size_type word_bits = 64;
+
+    static constexpr size_type word_of (size_type i) noexcept {
+        return i / word_bits;
+    }
+
+    static constexpr word_type mask_of (size_type i) noexcept {
+        return word_type (1) << (i % word_bits);
+    }
+
+public:
+    unique_resource_vector () = default;
+
+    explicit unique_resource_vector (const D& d)
+        : deleter_ (d)
+        { }
+
+    explicit unique_resource_vector (D&& d)
+        : deleter_ (std::move (d))
+        { }
+
+    unique_resource_vector (unique_resource_vector&& other) noexcept
+        : resources_ (std::move (other.resources_)),
+          owned_ (std::move (other.owned_)),
+          deleter_ (other.deleter_.move ()) {
+        other.resources_.clear ();
+        other.owned_.clear ();
+    }
+
+    unique_resource_vector& operator= (unique_resource_vector&&) = delete;
+
+    unique_resource_vector (const unique_resource_vector&) = delete;
+    unique_resource_vector& operator= (const unique_resource_vector&) = delete;
+
+    ~unique_resource_vector () {
+        reset_all ();
+    }
+
+    //
+    // As when constructing a unique_resource, r is released if it cannot be
+    // stored:
+    //
+    void push_back (const R& r) {
+        push_back_or_delete (r);
+    }
+
+    void push_back (R&& r) {
+        push_back_or_delete (std::move (r));
+    }
+
+    template< typename ...Args >
+    R& emplace_back (Args&&... args) {
+        const auto i = resources_.size ();
+
+        if (word_of (i) == owned_.size ())
+            owned_.push_back (0);
+
+        //
+        // The bit is set only once the resource is in place:
+        //
+        R& r = resources_.emplace_back (std::forward< Args > (args)...);
+        owned_ [word_of (i)] |= mask_of (i);
+
+        return r;
+    }
+
+    void pop_back () noexcept {
+        const auto i = resources_.size () - 1;
+
+        reset (i);
+        resources_.pop_back ();
+
+        if (0 == i % word_bits)
+            owned_.pop_back ();
+    }
+
+    void reserve (size_type n) {
+        resources_.reserve (n);
+        owned_.reserve ((n + word_bits - 1) / word_bits);
+    }
+
+    void clear () noexcept {
+        reset_all ();
+        resources_.clear ();
+        owned_.clear ();
+    }
+
+    void reset (size_type i) noexcept {
+        word_type& w = owned_ [word_of (i)];
+
+        if (w & mask_of (i)) {
+            w &= ~mask_of (i);
+            get_deleter ()(resources_ [i]);
+        }
+    }
+
+    void reset (size_type i, R&& r)
+        noexcept (std::is_nothrow_move_assignable_v< R >) {
+        reset (i);
+        resources_ [i] = std::move (r);
+        owned_ [word_of (i)] |= mask_of (i);
+    }
+
+    const R& release (size_type i) noexcept {
+        owned_ [word_of (i)] &= ~mask_of (i);
+        return resources_ [i];
+    }
+
+    void release_all () noexcept {
+        for (auto& w : owned_)
+            w = 0;
+    }
+
+    //
+    // Runs the deleter over all owned elements, keeping the handles. A bulk
+    // deleter gets each contiguous run of owned elements in one call:
+    //
+    void reset_all () noexcept {
+        if constexpr (is_bulk_deleter_v< D, R >) {
+            for (size_type i = find (0, true), j; i < size (); i = find (j, true)) {
+                j = find (i, false);
+                detail::delete_n (get_deleter (), resources_.data () + i, j - i);
+            }
+
+            release_all ();
+        }
+        else {
+            for (size_type n = 0; n < owned_.size (); ++n) {
+                for (word_type w = std::exchange (owned_ [n], 0); w; w &= w - 1)
+                    get_deleter ()(
+                        resources_ [n * word_bits + detail::countr_zero (w)]);
+            }
+        }
+    }
+
+    bool owns (size_type i) const noexcept {
+        return owned_ [word_of (i)] & mask_of (i);
+    }
+
+    const R& get (size_type i) const noexcept {
+        return resources_ [i];
+    }
+
+    const R& operator[] (size_type i) const noexcept {
+        return resources_ [i];
+    }
+
+    const R* data () const noexcept {
+        return resources_.data ();
+    }
+
+    size_type size () const noexcept {
+        return resources_.size ();
+    }
+
+    bool empty () const noexcept {
+        return resources_.empty ();
+    }
+
+    auto begin () const noexcept { return resources_.cbegin (); }
+    auto end () const noexcept { return resources_.cend (); }
+
+    D& get_deleter () noexcept {
+        return deleter_.get ();
+    }
+
+    const D& get_deleter () const noexcept {
+        return deleter_.get ();
+    }
+
+private:
+    template< typename T >
+    void push_back_or_delete (T&& r) {
+        UNIQUE_RESOURCE_TRY {
+            emplace_back (std::forward< T > (r));
+        }
+        UNIQUE_RESOURCE_CATCH (...) {
+            get_deleter ()(r);
+            detail::rethrow_helper< false > ();
+        }
+    }
+
+    //
+    // Position of the first element at or after i that is (or is not) owned:
+    //
+    size_type find (size_type i, bool owned) const noexcept {
+        for (const size_type n = size (); i < n; ) {
+            word_type w = owned_ [word_of (i)];
+
+            if (!owned)
+                w = ~w;
+
+            w &= ~word_type (0) << (i % word_bits);
+
+            if (w)
+                return (std::min) (
+                    n, word_of (i) * word_bits + detail::countr_zero (w));
+
+            i = (word_of (i) + 1) * word_bits;
+        }
+
+        return size ();
+    }
+
+private:
+    std::vector< R > resources_;
+    std::vector< word_type > owned_;
+
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS detail::box< D > deleter_{ D () };
+};
+
+////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template< typename Range, typename F >
+using acquired_t = std::decay_t< std::invoke_result_t<
+    F&, decltype (*std::begin (std::declval< const Range& > ())) > >;
+
+//
+// The state the acquisitions submitted to an executor share with the
+// caller, who waits for all of them. After a failure, the acquisitions that
+// have not started yet are skipped:
+//
+template< typename R, typename S, typename F >
+struct bulk_acquisition {
+    bulk_acquisition (F& f, std::size_t n, const S& s)
+        : function (f), invalid (s), results (n, R (s)), remaining (n)
+        { }
+
+    template< typename I >
+    void run (std::size_t i, I it) noexcept {
+        if (!failed.load (std::memory_order_relaxed)) {
+            UNIQUE_RESOURCE_TRY {
+                results [i] = function (*it);
+            }
+            UNIQUE_RESOURCE_CATCH (...) {
+#if !defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+                std::lock_guard< std::mutex > lock (mutex);
+
+                if (!error)
+                    error = std::current_exception ();
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+            }
+
+            if (!(results [i] != invalid))
+                failed.store (true, std::memory_order_relaxed);
+        }
+
+        done (1);
+    }
+
+    void done (std::size_t n) noexcept {
+        std::lock_guard< std::mutex > lock (mutex);
+
+        if (0 == (remaining -= n))
+            completed.notify_one ();
+    }
+
+    void wait () noexcept {
+        std::unique_lock< std::mutex > lock (mutex);
+        completed.wait (lock, [this] { return 0 == remaining; });
+    }
+
+    void rethrow () {
+#if !defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+        if (error)
+            std::rethrow_exception (error);
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+    }
+
+    F& function;
+    const S& invalid;
+
+    std::vector< R > results;
+
+    std::atomic< bool > failed{ false };
+
+    std::mutex mutex;
+    std::condition_variable completed;
+    std::size_t remaining;
+
+#if !defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+    std::exception_ptr error;
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+};
+
+} // namespace detail
+
+//
+// Acquires f (x) for each x of a forward range, all or nothing: at the first
+// result equal to invalid, those acquired so far are released together, in
+// bulk if the deleter can, and the result is empty. So are they if f throws,
+// before the exception propagates.
+//
+template< typename Range, typename F, typename S, typename D >
+unique_resource_vector< detail::acquired_t< Range, F >, std::decay_t< D > >
+make_unique_resources_checked (const Range& range, F&& f, const S& invalid, D&& d) {
+    using R = detail::acquired_t< Range, F >;
+
+    unique_resource_vector< R, std::decay_t< D > > v (std::forward< D > (d));
+    v.reserve (std::distance (std::begin (range), std::end (range)));
+
+    for (const auto& x : range) {
+        R r = f (x);
+
+        if (!(r != invalid)) {
+            v.clear ();
+            break;
+        }
+
+        v.push_back (std::move (r));
+    }
+
+    return v;
+}
+
+//
+// As above, with the acquisitions overlapped on an executor, any object with
+// a submit (g) member that runs g () eventually, on any thread (e.g., a
+// reaper). All acquisitions complete before the function returns; those
+// that start after a failure are skipped. Handy when each one waits on the
+// kernel or the network, e.g., opening thousands of files or connections.
+//
+template< typename E, typename Range, typename F, typename S, typename D >
+unique_resource_vector< detail::acquired_t< Range, F >, std::decay_t< D > >
+make_unique_resources_checked (
+    E& executor, const Range& range, F&& f, const S& invalid, D&& d) {
+    using R = detail::acquired_t< Range, F >;
+
+    const auto first = std::begin (range), last = std::end (range);
+    const std::size_t n = std::distance (first, last);
+
+    unique_resource_vector< R, std::decay_t< D > > v (std::forward< D > (d));
+    v.reserve (n);
+
+    detail::bulk_acquisition< R, S, std::remove_reference_t< F > > a (f, n, invalid);
+
+    //
+    // Nothing is left referring to a when a submission throws:
+    //
+    std::size_t i = 0;
+
+    UNIQUE_RESOURCE_TRY {
+        for (auto it = first; it != last; ++it, ++i)
+            executor.submit ([p = &a, i, it] { p->run (i, it); });
+    }
+    UNIQUE_RESOURCE_CATCH (...) {
+        a.failed.store (true, std::memory_order_relaxed);
+        a.done (n - i);
+        a.wait ();
+
+        for (auto& r : a.results)
+            if (r != invalid)
+                v.push_back (std::move (r));
+
+        detail::rethrow_helper< false > ();
+    }
+
+    a.wait ();
+
+    //
+    // Within the reserved capacity, in order:
+    //
+    for (auto& r : a.results)
+        if (r != invalid)
+            v.push_back (std::move (r));
+
+    a.rethrow ();
+
+    if (v.size () != n)
+        v.clear ();
+
+    return v;
+}
+
+}}
+
+#endif // STD_UNIQUE_RESOURCE_VECTOR_HPP
@@ -0,0 +1,224 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_UNIQUE_RESOURCES_HPP
+#define STD_UNIQUE_RESOURCES_HPP
+
+#include <unique_resource.hh>
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace std {
+namespace experimental {
+namespace detail {
+
+//
+// The smallest unsigned type with a bit per resource:
+//
+template< std::size_t N >
+using ownership_word_t = std::conditional_t<
+    N <= 8, std::uint8_t, std::conditional_t<
+        N <= 16, std::uint16_t, std::conditional_t<
+            N <= 32, std::uint32_t, std::uint64_t > > >;
+
+//
+// The deleters, of a distinct type each so that empty ones of the same type
+// take no storage either:
+//
+template< std::size_t I, typename D >
+struct deleter_slot {
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS D value;
+};
+
+template< typename, typename ...D >
+struct deleter_slots;
+
+template< std::size_t ...I, typename ...D >
+struct deleter_slots< std::index_sequence< I... >, D... > {
+    using type = std::tuple< deleter_slot< I, D >... >;
+};
+
+template< typename ...D >
+using deleter_slots_t = typename deleter_slots<
+    std::index_sequence_for< D... >, D... >::type;
+
+} // namespace detail
+
+//
+// A fixed set of related resources, each a std::pair< R, D > of a resource
+// and its deleter type, owned together (e.g., a socket, an epoll descriptor
+// and a buffer): the handles are packed next to each other, the deleters
+// after them, empty ones taking no storage, and ownership is one bit per
+// resource in a single word. The owned resources are released in reverse
+// order of declaration. Element I has the unique_resource API, e.g.,
+// get< I > (), reset< I > (r).
+//
+template< typename ...P >
+struct unique_resources {
+    static constexpr std::size_t size = sizeof... (P);
+
+    static_assert (0 < size && size <= 64, "between 1 and 64 resources");
+
+    template< std::size_t I >
+    using resource_type = std::tuple_element_t<
+        I, std::tuple< typename P::first_type... > >;
+
+    template< std::size_t I >
+    using deleter_type = std::tuple_element_t<
+        I, std::tuple< typename P::second_type... > >;
+
+    static_assert (
+        (std::is_nothrow_move_constructible_v< typename P::first_type > && ...),
+        "resources must be nothrow_move_constructible");
+
+    static_assert (
+        (std::is_nothrow_move_constructible_v< typename P::second_type > && ...),
+        "deleters must be nothrow_move_constructible");
+
+private:
+    using word_type = detail::ownership_word_t< size >;
+
+    template< std::size_t I >
+    static constexpr word_type mask_of = word_type (1) << I;
+
+    static constexpr word_type all = word_type (~std::uint64_t (0) >> (64 - size));
+
+public:
+    //
+    // Owning nothing, with default constructed resources and deleters, to
+    // be acquired one by one with reset< I > (r):
+    //
+    unique_resources () = default;
+
+    //
+    // Owning all:
+    //
+    explicit unique_resources (P... p) noexcept
+        : unique_resources (std::index_sequence_for< P... > { }, std::move (p)...)
+        { }
+
+    unique_resources (unique_resources&& other) noexcept
+        : resources_ (std::move (other.resources_)),
+          deleters_ (std::move (other.deleters_)),
+          owned_ (std::exchange (other.owned_, 0))
+        { }
+
+    unique_resources& operator= (unique_resources&& other) noexcept {
+        if (this != &other) {
+            reset_all ();
+
+            resources_ = std::move (other.resources_);
+            deleters_ = std::move (other.deleters_);
+            owned_ = std::exchange (other.owned_, 0);
+        }
+
+        return *this;
+    }
+
+    unique_resources (const unique_resources&) = delete;
+    unique_resources& operator= (const unique_resources&) = delete;
+
+    ~unique_resources () {
+        reset_all ();
+    }
+
+    void swap (unique_resources& other) noexcept {
+        using std::swap;
+
+        swap (resources_, other.resources_);
+        swap (deleters_, other.deleters_);
+        swap (owned_, other.owned_);
+    }
+
+    template< std::size_t I >
+    bool owns () const noexcept {
+        return owned_ & mask_of< I >;
+    }
+
+    template< std::size_t I >
+    void reset () noexcept {
+        if (owned_ & mask_of< I >) {
+            owned_ &= ~mask_of< I >;
+            get_deleter< I > ()(std::get< I > (resources_));
+        }
+    }
+
+    template< std::size_t I >
+    void reset (resource_type< I >&& r)
+        noexcept (std::is_nothrow_move_assignable_v< resource_type< I > >) {
+        reset< I > ();
+        std::get< I > (resources_) = std::move (r);
+        owned_ |= mask_of< I >;
+    }
+
+    template< std::size_t I >
+    const resource_type< I >& release () noexcept {
+        owned_ &= ~mask_of< I >;
+        return get< I > ();
+    }
+
+    //
+    // All owned resources, last to first:
+    //
+    void reset_all () noexcept {
+        reset_all (std::make_index_sequence< size > { });
+    }
+
+    void release_all () noexcept {
+        owned_ = 0;
+    }
+
+    template< std::size_t I >
+    const resource_type< I >& get () const noexcept {
+        return std::get< I > (resources_);
+    }
+
+    template< std::size_t I >
+    deleter_type< I >& get_deleter () noexcept {
+        return std::get< I > (deleters_).value;
+    }
+
+    template< std::size_t I >
+    const deleter_type< I >& get_deleter () const noexcept {
+        return std::get< I > (deleters_).value;
+    }
+
+private:
+    template< std::size_t ...I >
+    unique_resources (std::index_sequence< I... >, P&&... p) noexcept
+        : resources_ (std::move (p.first)...),
+          deleters_ (detail::deleter_slot< I, typename P::second_type > {
+                  std::move (p.second) }...),
+          owned_ (all)
+        { }
+
+    template< std::size_t ...I >
+    void reset_all (std::index_sequence< I... >) noexcept {
+        if (owned_)
+            (reset< size - 1 - I > (), ...);
+    }
+
+private:
+    //
+    // The word may go in the tail padding of the resources:
+    //
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS
+    std::tuple< typename P::first_type... > resources_;
+
+    UNIQUE_RESOURCE_NO_UNIQUE_ADDRESS
+    detail::deleter_slots_t< typename P::second_type... > deleters_;
+
+    word_type owned_ = 0;
+};
+
+template< typename ...P >
+void swap (unique_resources< P... >& lhs, unique_resources< P... >& rhs) noexcept {
+    lhs.swap (rhs);
+}
+
+}}
+
+#endif // STD_UNIQUE_RESOURCES_HPP
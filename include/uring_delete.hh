@@ -0,0 +1,293 @@
+// -*- mode: c++; -*-
+
+#ifndef STD_URING_DELETE_HPP
+#define STD_URING_DELETE_HPP
+
+#include <unique_resource.hh>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include <unistd.h>
+
+#if defined (__linux__) && defined (__has_include)
+#  if __has_include (<linux/io_uring.h>)
+#    define UNIQUE_RESOURCE_HAVE_IO_URING 1
+#  endif
+#endif
+
+#if defined (UNIQUE_RESOURCE_HAVE_IO_URING)
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#endif // UNIQUE_RESOURCE_HAVE_IO_URING
+
+namespace std {
+namespace experimental {
+
+//
+// Batches close (2) calls as IORING_OP_CLOSE submissions on an io_uring
+// ring, submitted with one io_uring_enter (2) when the threshold is reached
+// or on flush. Descriptors stay open until submitted. Falls back to a
+// synchronous close when io_uring, or its close operation, is unavailable.
+// Not thread-safe; see instance () for the per-thread ring.
+//
+struct uring_closer {
+    explicit uring_closer (unsigned entries = 256, unsigned threshold = 64)
+        noexcept
+        : threshold_ (threshold) {
+#if defined (UNIQUE_RESOURCE_HAVE_IO_URING)
+        setup (entries);
+#endif // UNIQUE_RESOURCE_HAVE_IO_URING
+    }
+
+    uring_closer (const uring_closer&) = delete;
+    uring_closer& operator= (const uring_closer&) = delete;
+
+    ~uring_closer () {
+#if defined (UNIQUE_RESOURCE_HAVE_IO_URING)
+        if (available ()) {
+            flush ();
+
+            //
+            // Wait for in-flight closes before tearing down the ring:
+            //
+            for (; inflight_; reap ())
+                if (enter (0, inflight_, IORING_ENTER_GETEVENTS) < 0)
+                    break;
+
+            teardown ();
+        }
+#endif // UNIQUE_RESOURCE_HAVE_IO_URING
+    }
+
+    bool available () const noexcept {
+        return 0 <= ring_;
+    }
+
+    void close (int fd) noexcept {
+#if defined (UNIQUE_RESOURCE_HAVE_IO_URING)
+        if (available ()) {
+            if (sq_tail_ - load_acquire (sq_.head) == sq_entries_)
+                flush ();
+
+            if (sq_tail_ - load_acquire (sq_.head) < sq_entries_) {
+                const unsigned i = sq_tail_ & *sq_.mask;
+
+                io_uring_sqe& sqe = sqes_ [i];
+                std::memset (&sqe, 0, sizeof sqe);
+
+                sqe.opcode = IORING_OP_CLOSE;
+                sqe.fd = fd;
+
+                sq_.array [i] = i;
+                store_release (sq_.tail, ++sq_tail_);
+
+                if (++pending_ >= threshold_)
+                    flush ();
+
+                return;
+            }
+        }
+#endif // UNIQUE_RESOURCE_HAVE_IO_URING
+
+        ::close (fd);
+    }
+
+    //
+    // Submits all queued closes:
+    //
+    void flush () noexcept {
+#if defined (UNIQUE_RESOURCE_HAVE_IO_URING)
+        if (available ()) {
+            reap ();
+
+            for (int n; pending_; pending_ -= n, inflight_ += n) {
+                if ((n = enter (pending_, 0, 0)) <= 0)
+                    break;
+            }
+        }
+#endif // UNIQUE_RESOURCE_HAVE_IO_URING
+    }
+
+    std::size_t pending () const noexcept {
+        return pending_;
+    }
+
+    static uring_closer& instance () noexcept {
+        static thread_local uring_closer closer;
+        return closer;
+    }
+
+private:
+#if defined (UNIQUE_RESOURCE_HAVE_IO_URING)
+    static unsigned load_acquire (const unsigned* p) noexcept {
+        return __atomic_load_n (p, __ATOMIC_ACQUIRE);
+    }
+
+    static void store_release (unsigned* p, unsigned x) noexcept {
+        __atomic_store_n (p, x, __ATOMIC_RELEASE);
+    }
+
+    int enter (unsigned to_submit, unsigned min_complete, unsigned flags) noexcept {
+        return int (::syscall (
+            __NR_io_uring_enter, ring_, to_submit, min_complete, flags,
+            nullptr, 0));
+    }
+
+    //
+    // Completion results are dropped, as with an unchecked close (2):
+    //
+    void reap () noexcept {
+        const unsigned head = *cq_.head;
+        const unsigned tail = load_acquire (cq_.tail);
+
+        inflight_ -= tail - head;
+        store_release (cq_.head, tail);
+    }
+
+    bool supports_close () noexcept {
+        constexpr unsigned n = IORING_OP_LAST;
+
+        const std::size_t size =
+            sizeof (io_uring_probe) + n * sizeof (io_uring_probe_op);
+
+        std::unique_ptr< unsigned char [] > buf (new (std::nothrow) unsigned char [size]);
+
+        if (!buf)
+            return false;
+
+        std::memset (buf.get (), 0, size);
+        auto probe = reinterpret_cast< io_uring_probe* > (buf.get ());
+
+        if (0 > ::syscall (
+                __NR_io_uring_register, ring_, IORING_REGISTER_PROBE, probe, n))
+            return false;
+
+        return IORING_OP_CLOSE <= probe->last_op &&
+            (probe->ops [IORING_OP_CLOSE].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    void setup (unsigned entries) noexcept {
+        io_uring_params p;
+        std::memset (&p, 0, sizeof p);
+
+        ring_ = int (::syscall (__NR_io_uring_setup, entries, &p));
+
+        if (ring_ < 0)
+            return;
+
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof (io_uring_cqe);
+
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+
+        if (single)
+            sq_size_ = cq_size_ = (std::max) (sq_size_, cq_size_);
+
+        sq_ptr_ = ::mmap (
+            0, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_, IORING_OFF_SQ_RING);
+
+        cq_ptr_ = single ? sq_ptr_ : ::mmap (
+            0, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_, IORING_OFF_CQ_RING);
+
+        sqes_size_ = p.sq_entries * sizeof (io_uring_sqe);
+
+        void* sqes = ::mmap (
+            0, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            ring_, IORING_OFF_SQES);
+
+        if (MAP_FAILED == sq_ptr_ || MAP_FAILED == cq_ptr_ ||
+            MAP_FAILED == sqes || !supports_close ()) {
+            sqes_ = MAP_FAILED == sqes ? nullptr : static_cast< io_uring_sqe* > (sqes);
+            teardown ();
+            return;
+        }
+
+        sqes_ = static_cast< io_uring_sqe* > (sqes);
+
+        auto sq = static_cast< char* > (sq_ptr_);
+        auto cq = static_cast< char* > (cq_ptr_);
+
+        sq_.head  = reinterpret_cast< unsigned* > (sq + p.sq_off.head);
+        sq_.tail  = reinterpret_cast< unsigned* > (sq + p.sq_off.tail);
+        sq_.mask  = reinterpret_cast< unsigned* > (sq + p.sq_off.ring_mask);
+        sq_.array = reinterpret_cast< unsigned* > (sq + p.sq_off.array);
+
+        cq_.head  = reinterpret_cast< unsigned* > (cq + p.cq_off.head);
+        cq_.tail  = reinterpret_cast< unsigned* > (cq + p.cq_off.tail);
+
+        sq_entries_ = p.sq_entries;
+        sq_tail_ = *sq_.tail;
+    }
+
+    void teardown () noexcept {
+        if (sqes_)
+            ::munmap (sqes_, sqes_size_);
+
+        if (cq_ptr_ != sq_ptr_ && MAP_FAILED != cq_ptr_ && cq_ptr_)
+            ::munmap (cq_ptr_, cq_size_);
+
+        if (MAP_FAILED != sq_ptr_ && sq_ptr_)
+            ::munmap (sq_ptr_, sq_size_);
+
+        ::close (ring_);
+        ring_ = -1;
+    }
+
+private:
+    struct ring_pointers {
+        unsigned* head = nullptr;
+        unsigned* tail = nullptr;
+        unsigned* mask = nullptr;
+        unsigned* array = nullptr;
+    };
+
+    ring_pointers sq_, cq_;
+
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    io_uring_sqe* sqes_ = nullptr;
+
+    std::size_t sq_size_ = 0, cq_size_ = 0, sqes_size_ = 0;
+
+    unsigned sq_entries_ = 0;
+    unsigned sq_tail_ = 0;
+#endif // UNIQUE_RESOURCE_HAVE_IO_URING
+
+    int ring_ = -1;
+
+    unsigned threshold_;
+    unsigned pending_ = 0;
+    unsigned inflight_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////
+
+//
+// File descriptor deleter that closes through the calling thread's
+// uring_closer:
+//
+struct uring_fd_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int fd) const noexcept {
+        uring_closer::instance ().close (fd);
+    }
+
+    void operator() (const int* first, std::size_t n) const noexcept {
+        auto& closer = uring_closer::instance ();
+
+        for (; n; --n, ++first)
+            closer.close (*first);
+    }
+};
+
+}}
+
+#endif // STD_URING_DELETE_HPP
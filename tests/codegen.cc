@@ -0,0 +1,213 @@
+// -*- mode: c++ -*-
+
+//
+// Canonical uses of unique_resource and scope_exit, each next to the
+// hand-written C equivalent: ur_NAME against raw_NAME. codegen.sh compares
+// them in the optimized binary. The functions they call are defined in
+// codegen_extern.cc, out of the compiler's sight, and cannot throw; any
+// landing pad is overhead.
+//
+
+#include <unique_resource.hh>
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace X = std::experimental;
+
+extern "C" {
+
+void release_resource (int) noexcept;
+
+int open_fd (const char*) noexcept;
+void close_fd (int) noexcept;
+void use_fd (int) noexcept;
+
+void* alloc_block (std::size_t) noexcept;
+void free_block (void*) noexcept;
+void use_block (void*) noexcept;
+
+void work () noexcept;
+void undo () noexcept;
+
+}
+
+struct flag_delete {
+    void operator() (int fd) const noexcept {
+        release_resource (fd);
+    }
+};
+
+struct sentinel_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int fd) const noexcept {
+        release_resource (fd);
+    }
+};
+
+struct raw_flag {
+    int fd;
+    bool owns;
+};
+
+struct raw_sentinel {
+    int fd;
+};
+
+using ur_flag = X::unique_resource< int, flag_delete >;
+using ur_sentinel = X::unique_resource< int, sentinel_delete >;
+
+#define CODEGEN extern "C" __attribute__ ((noinline, used))
+
+////////////////////////////////////////////////////////////////////////
+
+CODEGEN void raw_flag_move_construct (void* p, raw_flag& x) noexcept {
+    ::new (p) raw_flag { x.fd, x.owns };
+    x.owns = false;
+}
+
+CODEGEN void ur_flag_move_construct (void* p, ur_flag& x) noexcept {
+    ::new (p) ur_flag (std::move (x));
+}
+
+CODEGEN void raw_flag_move_assign (raw_flag& a, raw_flag& b) noexcept {
+    if (&a != &b) {
+        if (a.owns) {
+            a.owns = false;
+            release_resource (a.fd);
+        }
+
+        a.fd = b.fd;
+        a.owns = b.owns;
+        b.owns = false;
+    }
+}
+
+CODEGEN void ur_flag_move_assign (ur_flag& a, ur_flag& b) noexcept {
+    a = std::move (b);
+}
+
+CODEGEN void raw_flag_swap (raw_flag& a, raw_flag& b) noexcept {
+    std::swap (a.fd, b.fd);
+    std::swap (a.owns, b.owns);
+}
+
+CODEGEN void ur_flag_swap (ur_flag& a, ur_flag& b) noexcept {
+    swap (a, b);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+CODEGEN void raw_sentinel_move_construct (void* p, raw_sentinel& x) noexcept {
+    ::new (p) raw_sentinel { x.fd };
+    x.fd = -1;
+}
+
+CODEGEN void ur_sentinel_move_construct (void* p, ur_sentinel& x) noexcept {
+    ::new (p) ur_sentinel (std::move (x));
+}
+
+CODEGEN void raw_sentinel_move_assign (raw_sentinel& a, raw_sentinel& b) noexcept {
+    if (&a != &b) {
+        if (a.fd != -1) {
+            release_resource (a.fd);
+            a.fd = -1;
+        }
+
+        a.fd = b.fd;
+        b.fd = -1;
+    }
+}
+
+CODEGEN void ur_sentinel_move_assign (ur_sentinel& a, ur_sentinel& b) noexcept {
+    a = std::move (b);
+}
+
+CODEGEN void raw_sentinel_swap (raw_sentinel& a, raw_sentinel& b) noexcept {
+    std::swap (a.fd, b.fd);
+}
+
+CODEGEN void ur_sentinel_swap (ur_sentinel& a, ur_sentinel& b) noexcept {
+    swap (a, b);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+struct fd_delete {
+    void operator() (int fd) const noexcept {
+        close_fd (fd);
+    }
+};
+
+CODEGEN void raw_fd (const char* path) noexcept {
+    const int fd = open_fd (path);
+
+    if (-1 != fd) {
+        use_fd (fd);
+        close_fd (fd);
+    }
+}
+
+CODEGEN void ur_fd (const char* path) noexcept {
+    auto fd = X::make_unique_resource_checked (open_fd (path), -1, fd_delete { });
+
+    if (-1 != fd.get ())
+        use_fd (fd.get ());
+}
+
+struct block_delete {
+    static constexpr void* invalid_resource = nullptr;
+
+    void operator() (void* p) const noexcept {
+        free_block (p);
+    }
+};
+
+CODEGEN void raw_pointer (std::size_t n) noexcept {
+    void* p = alloc_block (n);
+
+    if (p) {
+        use_block (p);
+        free_block (p);
+    }
+}
+
+CODEGEN void ur_pointer (std::size_t n) noexcept {
+    X::unique_resource< void*, block_delete > p (alloc_block (n), block_delete { });
+
+    if (p.get ())
+        use_block (p.get ());
+}
+
+CODEGEN void raw_scope_exit () noexcept {
+    work ();
+    undo ();
+}
+
+CODEGEN void ur_scope_exit () noexcept {
+    auto g = X::make_scope_exit ([] () noexcept { undo (); });
+    work ();
+}
+
+CODEGEN void raw_scope_exit_released (bool commit) noexcept {
+    work ();
+
+    if (!commit)
+        undo ();
+}
+
+CODEGEN void ur_scope_exit_released (bool commit) noexcept {
+    auto g = X::make_scope_exit ([] () noexcept { undo (); });
+    work ();
+
+    if (commit)
+        g.release ();
+}
+
+////////////////////////////////////////////////////////////////////////
+
+int main () {
+    return 0;
+}
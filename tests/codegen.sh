@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# Compares every ur_NAME function of the codegen program with raw_NAME, its
+# hand-written equivalent: fails if it has more than CODEGEN_BUDGET extra
+# instructions, or any extra call, branch or stack access, or any exception
+# handling call, or if there is none to compare. Skipped (exit 77) without
+# objdump.
+#
+
+OBJDUMP=${OBJDUMP:-objdump}
+CODEGEN_BUDGET=${CODEGEN_BUDGET:-0}
+
+command -v "$OBJDUMP" >/dev/null 2>&1 || exit 77
+
+"$OBJDUMP" -d --no-show-raw-insn ./codegen | awk -v budget="$CODEGEN_BUDGET" '
+    /^[0-9a-f]+ <(raw|ur)_[a-z_]+>:$/ {
+        name = substr ($2, 2, length ($2) - 3)
+        next
+    }
+
+    /^$/ {
+        name = ""
+    }
+
+    #
+    # Instructions, less the padding:
+    #
+    !name || !/^ +[0-9a-f]+:\t/ || /\t(nop|xchg +%ax,%ax|(data16 |cs )+nop)/ {
+        next
+    }
+
+    {
+        insns [name]++
+    }
+
+    /\tcall/ {
+        calls [name]++
+    }
+
+    /\tj[a-z]+ / {
+        branches [name]++
+    }
+
+    /\t(push|pop)|%rsp/ {
+        stack [name]++
+    }
+
+    /<(_Unwind_Resume|__cxa_|_ZSt9terminate|__clang_call_terminate)/ {
+        eh [name]++
+    }
+
+    END {
+        failures = 0
+        compared = 0
+
+        printf "%-28s %11s %11s %11s %11s %5s\n",
+            "", "insns", "calls", "branches", "stack", "eh"
+
+        for (k in insns) {
+            if (k !~ /^ur_/)
+                continue
+
+            x = substr (k, 4)
+            raw = "raw_" x
+
+            ++compared
+
+            printf "%-28s %5d %5d %5d %5d %5d %5d %5d %5d %5d\n", x,
+                insns [raw], insns [k], calls [raw], calls [k],
+                branches [raw], branches [k], stack [raw], stack [k], eh [k]
+
+            if (!(raw in insns) ||
+                insns [k] > insns [raw] + budget ||
+                calls [k] > calls [raw] ||
+                branches [k] > branches [raw] ||
+                stack [k] > stack [raw] ||
+                eh [k] > 0) {
+                print "FAIL: " x
+                ++failures
+            }
+        }
+
+        if (!compared) {
+            print "FAIL: no ur_ function found"
+            ++failures
+        }
+
+        exit failures != 0
+    }'
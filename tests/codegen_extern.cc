@@ -0,0 +1,51 @@
+// -*- mode: c++ -*-
+
+//
+// What the codegen functions call, in a separate translation unit so that
+// the compiler cannot see through it:
+//
+
+#include <cstddef>
+#include <cstdlib>
+
+extern "C" {
+
+static volatile int sink;
+
+void release_resource (int x) noexcept {
+    sink = x;
+}
+
+int open_fd (const char*) noexcept {
+    return sink;
+}
+
+void close_fd (int x) noexcept {
+    sink = x;
+}
+
+void use_fd (int x) noexcept {
+    sink = x;
+}
+
+void* alloc_block (std::size_t n) noexcept {
+    return std::malloc (n);
+}
+
+void free_block (void* p) noexcept {
+    std::free (p);
+}
+
+void use_block (void*) noexcept {
+    sink = 0;
+}
+
+void work () noexcept {
+    sink = 0;
+}
+
+void undo () noexcept {
+    sink = 1;
+}
+
+}
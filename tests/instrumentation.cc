@@ -0,0 +1,236 @@
+// -*- mode: c++ -*-
+
+//
+// Built with UNIQUE_RESOURCE_INSTRUMENTATION defined, and a sampling period
+// of one (see Makefile.am):
+//
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE instrumentation
+
+#include <unique_resource.hh>
+#include <resource_stats.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <numeric>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace X = std::experimental;
+
+namespace {
+
+static std::vector< int > calls;
+
+struct flag_delete {
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+struct sentinel_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+struct bulk_delete {
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+
+    void operator() (const int* first, std::size_t n) const noexcept {
+        calls.insert (calls.end (), first, first + n);
+    }
+};
+
+struct exit_delete {
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+struct guard_function {
+    void operator() () const noexcept {
+        calls.push_back (0);
+    }
+};
+
+//
+// The statistics of the type whose name contains s:
+//
+X::resource_stats stats_of (const std::string& s) {
+    for (auto& x : X::resource_stats_snapshot ())
+        if (std::string::npos != x.type.find (s))
+            return x;
+
+    return { };
+}
+
+std::uint64_t sum (const X::resource_stats::histogram& h) {
+    return std::accumulate (h.begin (), h.end (), std::uint64_t (0));
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(instrumentation)
+
+BOOST_AUTO_TEST_CASE (unique_resource_test) {
+    {
+        auto a = X::make_unique_resource (1, flag_delete { });
+        auto b = X::make_unique_resource (2, flag_delete { });
+        auto c = X::make_unique_resource_checked (3, 3, flag_delete { });
+
+        BOOST_TEST (2U == stats_of ("flag_delete").live ());
+
+        //
+        // Moves carry the resource along, without counting:
+        //
+        auto d = std::move (a);
+        a = std::move (d);
+
+        a.reset ();
+        b.release ();
+    }
+
+    const auto s = stats_of ("flag_delete");
+
+    BOOST_TEST (std::string::npos != s.type.find ("unique_resource<int"));
+
+    BOOST_TEST (2U == s.acquisitions);
+    BOOST_TEST (2U == s.releases);
+    BOOST_TEST (1U == s.leaks);
+    BOOST_TEST (1U == s.invocations);
+    BOOST_TEST (0U == s.live ());
+
+    BOOST_TEST (s.releases == sum (s.lifetime));
+    BOOST_TEST (s.invocations == sum (s.latency));
+}
+
+BOOST_AUTO_TEST_CASE (sentinel_test) {
+    {
+        X::unique_resource< int, sentinel_delete > a (1, sentinel_delete { });
+        X::unique_resource< int, sentinel_delete > b (-1, sentinel_delete { }, false);
+
+        swap (a, b);
+        b.reset (2);
+    }
+
+    const auto s = stats_of ("sentinel_delete");
+
+    BOOST_TEST (2U == s.acquisitions);
+    BOOST_TEST (2U == s.invocations);
+    BOOST_TEST (0U == s.leaks);
+    BOOST_TEST (0U == s.live ());
+}
+
+//
+// Holding the invalid value from the start, nothing is acquired:
+//
+BOOST_AUTO_TEST_CASE (invalid_sentinel_test) {
+    const auto before = stats_of ("sentinel_delete");
+
+    {
+        X::unique_resource< int, sentinel_delete > a (-1, sentinel_delete { });
+        auto b = X::make_unique_resource (-1, sentinel_delete { });
+
+        BOOST_TEST (before.live () == stats_of ("sentinel_delete").live ());
+    }
+
+    const auto s = stats_of ("sentinel_delete");
+
+    BOOST_TEST (before.acquisitions == s.acquisitions);
+    BOOST_TEST (before.releases == s.releases);
+    BOOST_TEST (before.invocations == s.invocations);
+    BOOST_TEST (0U == s.live ());
+}
+
+//
+// One call of a bulk deleter counts one invocation per resource:
+//
+BOOST_AUTO_TEST_CASE (bulk_test) {
+    {
+        std::vector< X::unique_resource< int, bulk_delete > > v;
+
+        for (int i = 0; i < 3; ++i)
+            v.push_back (X::make_unique_resource (int (i), bulk_delete { }));
+
+        calls.clear ();
+        X::reset_all (v.begin (), v.end ());
+
+        BOOST_TEST ((std::vector< int > { 0, 1, 2 }) == calls);
+    }
+
+    const auto s = stats_of ("bulk_delete");
+
+    BOOST_TEST (3U == s.acquisitions);
+    BOOST_TEST (3U == s.releases);
+    BOOST_TEST (0U == s.leaks);
+    BOOST_TEST (3U == s.invocations);
+    BOOST_TEST (0U == s.live ());
+
+    BOOST_TEST (s.invocations == sum (s.latency));
+}
+
+BOOST_AUTO_TEST_CASE (scope_guard_test) {
+    {
+        auto a = X::make_scope_exit (guard_function { });
+        auto b = X::make_scope_exit (guard_function { });
+
+        b.release ();
+    }
+
+    const auto s = stats_of ("guard_function");
+
+    BOOST_TEST (2U == s.acquisitions);
+    BOOST_TEST (2U == s.releases);
+    BOOST_TEST (1U == s.invocations);
+    BOOST_TEST (0U == s.live ());
+}
+
+//
+// The counters of exited threads are kept:
+//
+BOOST_AUTO_TEST_CASE (thread_test) {
+    const auto before = stats_of ("flag_delete").acquisitions;
+
+    std::thread ([] {
+        for (int i = 0; i < 100; ++i)
+            auto x = X::make_unique_resource (int (i), flag_delete { });
+    }).join ();
+
+    const auto s = stats_of ("flag_delete");
+
+    BOOST_TEST (before + 100 == s.acquisitions);
+    BOOST_TEST (0U == s.live ());
+}
+
+//
+// A resource released after the thread's counters are gone, as a static one
+// at program exit, is still counted:
+//
+BOOST_AUTO_TEST_CASE (exit_test) {
+    std::thread ([] {
+        //
+        // Constructed, empty, before the counters, hence destroyed after:
+        //
+        static thread_local std::optional<
+            X::unique_resource< int, exit_delete > > x;
+
+        x.emplace (1, exit_delete { });
+    }).join ();
+
+    const auto s = stats_of ("exit_delete");
+
+    BOOST_TEST (1U == s.acquisitions);
+    BOOST_TEST (1U == s.releases);
+    BOOST_TEST (1U == s.invocations);
+    BOOST_TEST (0U == s.live ());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,21 @@
 #define BOOST_TEST_MODULE unique_resource
 
 #include <unique_resource.hh>
+#include <async_deleter.hh>
+#include <atomic_unique_resource.hh>
+#include <defer_stack.hh>
+#include <fd_delete.hh>
+#include <inline_deleter.hh>
+#include <rcu_resource.hh>
+#include <relocate.hh>
+#include <resource_arena.hh>
+#include <resource_pool.hh>
+#include <shared_resource.hh>
+#include <unique_resource_vector.hh>
+#include <uring_delete.hh>
+#include <unique_resources.hh>
+
+#include <fcntl.h>
 
 #include <boost/hana/cartesian_product.hpp>
 #include <boost/hana/for_each.hpp>
@@ -19,11 +34,49 @@ using fmt = boost::format;
 #include <boost/test/unit_test.hpp>
 namespace utf = boost::unit_test;
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <exception>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 namespace X = std::experimental;
 
+//
+// Fails the next allocation, when set (see defer_stack_test and
+// unique_resource_vector_test):
+//
+static bool fail_next_allocation /* = false */;
+
+void* operator new (std::size_t n) {
+    if (std::exchange (fail_next_allocation, false))
+        throw std::bad_alloc ();
+
+    if (void* p = std::malloc (n ? n : 1))
+        return p;
+
+    throw std::bad_alloc ();
+}
+
+//
+// Out of line, not to pair std::free with a new-expression in sight of GCC's
+// -Wmismatched-new-delete:
+//
+__attribute__ ((noinline))
+void operator delete (void* p) noexcept {
+    std::free (p);
+}
+
+void operator delete (void* p, std::size_t) noexcept {
+    ::operator delete (p);
+}
+
 BOOST_AUTO_TEST_SUITE(details)
 
 ////////////////////////////////////////////////////////////////////////
@@ -516,4 +569,1795 @@ BOOST_AUTO_TEST_CASE (unique_resource_big_exception_safety_test) {
 #endif // 0
 }
 
+////////////////////////////////////////////////////////////////////////
+
+namespace _08 {
+
+static int counter /* = 0 */;
+
+struct fd_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int) const noexcept {
+        ++counter;
+    }
+};
+
+struct ptr_delete {
+    static constexpr void* invalid_resource = nullptr;
+
+    void operator() (void*) const noexcept {
+        ++counter;
+    }
+};
+
+struct stateless_delete {
+    void operator() (int) const noexcept {
+        ++counter;
+    }
+};
+
+struct stateful_delete {
+    int state = 0;
+
+    void operator() (int) const noexcept {
+        ++counter;
+    }
+};
+
+static_assert (sizeof (X::unique_resource< int,   fd_delete  >) == sizeof (int));
+static_assert (sizeof (X::unique_resource< void*, ptr_delete >) == sizeof (void*));
+
+static_assert (
+    sizeof (X::unique_resource< int, stateless_delete >) ==
+    sizeof (std::pair< int, bool >));
+
+static_assert (
+    sizeof (X::unique_resource< int, stateful_delete >) ==
+    sizeof (std::tuple< int, int, bool >));
+
+static_assert (
+    sizeof (X::unique_resource< int, void(*)(int) >) ==
+    sizeof (std::tuple< int, void(*)(int), bool >));
+
+} // namespace _08
+
+BOOST_AUTO_TEST_CASE (unique_resource_sentinel_test) {
+    using namespace _08;
+
+    {
+        counter = 0;
+        { auto x = X::make_unique_resource (3, fd_delete { }); }
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+        { auto x = X::make_unique_resource (-1, fd_delete { }); }
+        BOOST_TEST (0 == counter);
+    }
+
+    {
+        counter = 0;
+        { auto x = X::make_unique_resource_checked (3, 3, fd_delete { }); }
+        BOOST_TEST (0 == counter);
+    }
+
+    {
+        counter = 0;
+
+        auto x = X::make_unique_resource (3, fd_delete { });
+        BOOST_TEST (3 == x.release ());
+        BOOST_TEST (-1 == x.get ());
+
+        x.reset ();
+        BOOST_TEST (0 == counter);
+
+        x.reset (4);
+        BOOST_TEST (4 == x.get ());
+
+        auto y (std::move (x));
+        BOOST_TEST (-1 == x.get ());
+        BOOST_TEST ( 4 == y.get ());
+
+        x = std::move (y);
+        BOOST_TEST (-1 == y.get ());
+        BOOST_TEST ( 4 == x.get ());
+
+        x.reset ();
+        x.reset ();
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+
+        int i = 0;
+        { auto x = X::make_unique_resource ((void*)&i, ptr_delete { }); }
+        { auto x = X::make_unique_resource ((void*)nullptr, ptr_delete { }); }
+
+        BOOST_TEST (1 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _09 {
+
+static int counter /* = 0 */;
+
+static void f (int) noexcept {
+    ++counter;
+}
+
+static_assert (std::is_empty_v< X::deleter_constant< &f > >);
+static_assert (X::deleter_constant< &f >::value == &f);
+
+static_assert (
+    sizeof (X::static_unique_resource< int, &f >) ==
+    sizeof (std::pair< int, bool >));
+
+static_assert (sizeof (X::static_unique_resource< int, &f, -1 >) == sizeof (int));
+
+} // namespace _09
+
+BOOST_AUTO_TEST_CASE (static_deleter_test) {
+    using namespace _09;
+
+    {
+        counter = 0;
+        { auto x = X::make_unique_resource< &f > (3); }
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+        { auto x = X::make_unique_resource_checked< &f > (3, 3); }
+        { auto x = X::make_unique_resource_checked< &f > (3, -1); }
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+
+        {
+            X::static_unique_resource< int, &f, -1 > x (3, X::deleter_constant< &f, -1 > { });
+            auto y (std::move (x));
+            BOOST_TEST (-1 == x.get ());
+            BOOST_TEST ( 3 == y.get ());
+        }
+
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+
+        {
+            using T = X::unique_resource< int, std::function< void(int) > >;
+            T t = X::make_unique_resource< &f > (3);
+        }
+
+        BOOST_TEST (1 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _10 {
+
+static int counter /* = 0 */;
+
+static void f (int) {
+    ++counter;
+}
+
+struct S {
+    int* p;
+
+    S (int* p) noexcept : p (p) { ++*p; }
+    S (S&& other) noexcept : p (other.p) { ++*p; }
+    ~S () { --*p; }
+
+    void operator() (int) const { ++counter; }
+};
+
+using D = X::inline_deleter< void(int) >;
+
+static_assert (std::is_nothrow_move_constructible_v< D >);
+static_assert (sizeof (D) == 4 * sizeof (void*));
+
+} // namespace _10
+
+BOOST_AUTO_TEST_CASE (inline_deleter_test) {
+    using namespace _10;
+
+    {
+        counter = 0;
+        { auto x = X::make_unique_resource (0, D (f)); }
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+
+        int i = 1;
+        auto g = [&](int) { counter += i; };
+
+        {
+            using T = X::unique_resource< int, D >;
+
+            T x = X::make_unique_resource (0, g);
+            T y (std::move (x));
+            x = std::move (y);
+        }
+
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+
+        int live = 0;
+
+        {
+            D d (S { &live });
+            BOOST_TEST (1 == live);
+
+            D e (std::move (d));
+            BOOST_TEST (1 == live);
+
+            d = std::move (e);
+            BOOST_TEST (1 == live);
+            BOOST_TEST (false == bool (e));
+
+            d (0);
+        }
+
+        BOOST_TEST (0 == live);
+        BOOST_TEST (1 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _11 {
+
+static int counter /* = 0 */;
+
+struct fd_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int) const noexcept {
+        ++counter;
+    }
+};
+
+static void f (int) {
+    ++counter;
+}
+
+static_assert (X::is_trivially_relocatable_v< X::unique_resource< int, fd_delete > >);
+static_assert (X::is_trivially_relocatable_v< X::unique_resource< int, void(*)(int) > >);
+static_assert (X::is_trivially_relocatable_v< X::unique_resource< int&, fd_delete& > >);
+
+static_assert (!X::is_trivially_relocatable_v<
+               X::unique_resource< int, X::inline_deleter< void(int) > > >);
+
+} // namespace _11
+
+BOOST_AUTO_TEST_CASE (relocate_test) {
+    using namespace _11;
+
+    {
+        counter = 0;
+
+        {
+            X::relocating_vector< X::unique_resource< int, fd_delete > > v;
+
+            for (int i = 0; i < 100; ++i)
+                v.emplace_back (i, fd_delete { });
+
+            BOOST_TEST (100U == v.size ());
+            BOOST_TEST (0 == counter);
+
+            for (int i = 0; i < 100; ++i)
+                BOOST_TEST (i == v [i].get ());
+
+            v.pop_back ();
+            BOOST_TEST (1 == counter);
+        }
+
+        BOOST_TEST (100 == counter);
+    }
+
+    {
+        counter = 0;
+
+        {
+            using T = X::unique_resource< int, X::inline_deleter< void(int) > >;
+
+            X::relocating_vector< T > v;
+
+            for (int i = 0; i < 100; ++i)
+                v.emplace_back (i, f);
+
+            BOOST_TEST (0 == counter);
+        }
+
+        BOOST_TEST (100 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _12 {
+
+static int counter /* = 0 */;
+
+struct fd_delete {
+    void operator() (int fd) const noexcept {
+        counter += fd;
+    }
+};
+
+} // namespace _12
+
+BOOST_AUTO_TEST_CASE (unique_resource_vector_test) {
+    using namespace _12;
+
+    using T = X::unique_resource_vector< int, fd_delete >;
+
+    {
+        counter = 0;
+
+        {
+            T v;
+
+            for (int i = 0; i < 200; ++i)
+                v.push_back (1);
+
+            BOOST_TEST (200U == v.size ());
+            BOOST_TEST (true == v.owns (130));
+
+            BOOST_TEST (1 == v.release (130));
+            BOOST_TEST (false == v.owns (130));
+
+            v.reset (131);
+            BOOST_TEST (1 == counter);
+
+            v.reset (131, 100);
+            BOOST_TEST (true == v.owns (131));
+            BOOST_TEST (100 == v [131]);
+
+            v.pop_back ();
+            BOOST_TEST (2 == counter);
+        }
+
+        BOOST_TEST (2 + 197 + 100 == counter);
+    }
+
+    {
+        counter = 0;
+
+        {
+            T v;
+
+            for (int i = 0; i < 65; ++i)
+                v.push_back (1);
+
+            for (int i = 0; i < 65; ++i)
+                v.pop_back ();
+
+            BOOST_TEST (true == v.empty ());
+            BOOST_TEST (65 == counter);
+
+            for (int i = 0; i < 65; ++i)
+                v.push_back (1);
+
+            v.release_all ();
+        }
+
+        BOOST_TEST (65 == counter);
+    }
+
+    {
+        counter = 0;
+
+        {
+            T v;
+
+            for (int i = 0; i < 10; ++i)
+                v.push_back (1);
+
+            T w (std::move (v));
+            BOOST_TEST (true == v.empty ());
+            BOOST_TEST (10U == w.size ());
+        }
+
+        BOOST_TEST (10 == counter);
+    }
+
+    {
+        counter = 0;
+
+        {
+            T v;
+
+            //
+            // The handle given to a push_back that throws is released:
+            //
+            const int fd = 1;
+
+            fail_next_allocation = true;
+            BOOST_CHECK_THROW (v.push_back (fd), std::bad_alloc);
+
+            fail_next_allocation = true;
+            BOOST_CHECK_THROW (v.push_back (2), std::bad_alloc);
+
+            BOOST_TEST (!fail_next_allocation);
+            BOOST_TEST (1 + 2 == counter);
+            BOOST_TEST (true == v.empty ());
+        }
+
+        BOOST_TEST (1 + 2 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _13 {
+
+static int counter /* = 0 */;
+static int calls /* = 0 */;
+
+struct bulk_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int) const noexcept {
+        ++counter;
+        ++calls;
+    }
+
+    void operator() (const int*, std::size_t n) const noexcept {
+        counter += n;
+        ++calls;
+    }
+};
+
+static_assert ( X::is_bulk_deleter_v< bulk_delete, int >);
+static_assert (!X::is_bulk_deleter_v< _12::fd_delete, int >);
+static_assert ( X::is_bulk_deleter_v< X::fd_delete, int >);
+
+} // namespace _13
+
+BOOST_AUTO_TEST_CASE (bulk_deleter_test) {
+    using namespace _13;
+
+    {
+        counter = calls = 0;
+
+        {
+            X::unique_resource_vector< int, bulk_delete > v;
+
+            for (int i = 0; i < 200; ++i)
+                v.push_back (i);
+
+            v.release (10);
+            v.release (64);
+            v.release (199);
+        }
+
+        BOOST_TEST (197 == counter);
+        BOOST_TEST (3 == calls);
+    }
+
+    {
+        counter = calls = 0;
+
+        std::vector< X::unique_resource< int, bulk_delete > > v;
+
+        for (int i = 0; i < 100; ++i)
+            v.emplace_back (i, bulk_delete { });
+
+        v [5].release ();
+
+        X::reset_all (v.begin (), v.end ());
+
+        BOOST_TEST (99 == counter);
+        BOOST_TEST (2 == calls);
+
+        v.clear ();
+        BOOST_TEST (2 == calls);
+    }
+
+    {
+        int fds [2];
+        BOOST_TEST (0 == ::pipe (fds));
+
+        {
+            X::unique_resource_vector< int, X::fd_delete > v;
+            v.push_back (fds [0]);
+            v.push_back (fds [1]);
+        }
+
+        BOOST_TEST (-1 == ::close (fds [0]));
+        BOOST_TEST (-1 == ::close (fds [1]));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _14 {
+
+static std::atomic< int > counter /* = 0 */;
+static std::thread::id where;
+
+struct slow_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int) const noexcept {
+        where = std::this_thread::get_id ();
+        ++counter;
+    }
+};
+
+static_assert (
+    sizeof (X::unique_resource< int, X::async_deleter< slow_delete > >) ==
+    2 * sizeof (void*));
+
+} // namespace _14
+
+BOOST_AUTO_TEST_CASE (async_deleter_test) {
+    using namespace _14;
+
+    using D = X::async_deleter< slow_delete >;
+
+    {
+        counter = 0;
+
+        X::reaper r;
+
+        for (int i = 0; i < 10000; ++i)
+            X::make_unique_resource (i, D (slow_delete { }, r));
+
+        { X::make_unique_resource (-1, D (slow_delete { }, r)); }
+
+        r.flush ();
+
+        BOOST_TEST (10000 == counter);
+        BOOST_TEST ((std::this_thread::get_id () != where));
+    }
+
+    {
+        counter = 0;
+
+        {
+            X::reaper r (2, X::reaper_overflow::inline_delete);
+
+            for (int i = 0; i < 10000; ++i)
+                X::make_unique_resource (i, D (slow_delete { }, r));
+        }
+
+        BOOST_TEST (10000 == counter);
+    }
+
+    {
+        counter = 0;
+
+        {
+            X::reaper r (2, X::reaper_overflow::block);
+
+            std::vector< std::thread > v;
+
+            for (int j = 0; j < 4; ++j)
+                v.emplace_back ([&] {
+                    for (int i = 0; i < 1000; ++i)
+                        X::make_unique_resource (i, D (slow_delete { }, r));
+                });
+
+            for (auto& t : v)
+                t.join ();
+        }
+
+        BOOST_TEST (4000 == counter);
+    }
+
+    {
+        counter = 0;
+
+        { X::make_unique_resource (1, D ()); }
+        X::reaper::instance ().flush ();
+
+        BOOST_TEST (1 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+BOOST_AUTO_TEST_CASE (uring_delete_test) {
+    auto is_open = [](int fd) { return -1 != ::fcntl (fd, F_GETFD); };
+
+    {
+        X::uring_closer closer (8, 4);
+
+        int fds [6];
+
+        for (auto& fd : fds)
+            fd = ::open ("/dev/null", O_RDONLY);
+
+        for (auto fd : fds)
+            closer.close (fd);
+
+        if (closer.available ()) {
+            BOOST_TEST (2U == closer.pending ());
+            BOOST_TEST (true == is_open (fds [5]));
+        }
+
+        closer.flush ();
+        BOOST_TEST (0U == closer.pending ());
+
+        for (auto fd : fds)
+            BOOST_TEST (false == is_open (fd));
+    }
+
+    {
+        const int fd = ::open ("/dev/null", O_RDONLY);
+
+        {
+            X::unique_resource< int, X::uring_fd_delete > x (fd, X::uring_fd_delete { });
+            BOOST_TEST (sizeof x == sizeof (int));
+        }
+
+        X::uring_closer::instance ().flush ();
+        BOOST_TEST (false == is_open (fd));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _15 {
+
+static std::atomic< int > created /* = 0 */, destroyed /* = 0 */;
+
+struct factory {
+    int operator() () const {
+        return ++created;
+    }
+};
+
+struct deleter {
+    void operator() (int) const noexcept {
+        ++destroyed;
+    }
+};
+
+using pool_type = X::resource_pool< int, factory, deleter >;
+
+} // namespace _15
+
+BOOST_AUTO_TEST_CASE (resource_pool_test) {
+    using namespace _15;
+
+    {
+        created = destroyed = 0;
+
+        {
+            pool_type pool;
+
+            int x;
+
+            {
+                auto h = pool.acquire ();
+                x = h.get ();
+            }
+
+            BOOST_TEST (0 == destroyed);
+
+            {
+                auto h = pool.acquire ();
+                BOOST_TEST (x == h.get ());
+            }
+
+            BOOST_TEST (1 == created);
+        }
+
+        BOOST_TEST (1 == destroyed);
+    }
+
+    {
+        created = destroyed = 0;
+
+        {
+            pool_type pool (factory { }, deleter { }, 8, 4);
+
+            {
+                std::vector< pool_type::handle_type > v;
+
+                for (int i = 0; i < 100; ++i)
+                    v.push_back (pool.acquire ());
+            }
+
+            BOOST_TEST (100 == created);
+            BOOST_TEST (100 - 8 - 4 == destroyed);
+            BOOST_TEST (8U == pool.idle ());
+
+            pool.trim (2);
+            BOOST_TEST (2U >= pool.idle ());
+        }
+
+        BOOST_TEST (100 == destroyed);
+    }
+
+    {
+        created = destroyed = 0;
+
+        {
+            pool_type pool (factory { }, deleter { }, 64, 8);
+
+            std::vector< std::thread > v;
+
+            for (int j = 0; j < 4; ++j)
+                v.emplace_back ([&] {
+                    for (int i = 0; i < 1000; ++i) {
+                        auto a = pool.acquire ();
+                        auto b = pool.acquire ();
+                    }
+                });
+
+            for (auto& t : v)
+                t.join ();
+
+            BOOST_TEST (created >= 2);
+        }
+
+        BOOST_TEST (created == destroyed);
+    }
+
+    {
+        created = destroyed = 0;
+
+        {
+            pool_type pool;
+
+            std::vector< pool_type::handle_type > v;
+
+            for (int i = 0; i < 10; ++i)
+                v.push_back (pool.acquire ());
+
+            //
+            // Released on a thread that never acquired, into its cache:
+            //
+            std::thread ([&] {
+                v.clear ();
+                BOOST_TEST (0U == pool.idle ());
+            }).join ();
+
+            BOOST_TEST (10U == pool.idle ());
+        }
+
+        BOOST_TEST (10 == destroyed);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _16 {
+
+static std::atomic< int > counter /* = 0 */;
+
+struct fd_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int) const noexcept {
+        ++counter;
+    }
+};
+
+template< typename C >
+void do_shared_resource_test () {
+    {
+        counter = 0;
+
+        {
+            auto x = X::make_shared_resource< C > (3, fd_delete { });
+            BOOST_TEST (1 == x.use_count ());
+
+            auto y = x;
+            BOOST_TEST (2 == x.use_count ());
+            BOOST_TEST (3 == y.get ());
+
+            x.reset ();
+            BOOST_TEST (false == bool (x));
+            BOOST_TEST (0 == counter);
+        }
+
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+
+        { auto x = X::make_shared_resource_checked< C > (-1, -1, fd_delete { }); }
+        { auto x = X::make_shared_resource_checked< C > ( 3, -1, fd_delete { }); }
+
+        BOOST_TEST (1 == counter);
+    }
+
+    {
+        counter = 0;
+
+        //
+        // A biased owner merges released objects lazily, at the latest when
+        // it exits:
+        //
+        std::thread ([] {
+            for (int i = 0; i < 100; ++i) {
+                auto x = X::make_shared_resource< C > (i, fd_delete { });
+
+                std::vector< std::thread > v;
+
+                for (int j = 0; j < 4; ++j)
+                    v.emplace_back ([y = x] () mutable {
+                        for (int k = 0; k < 100; ++k) {
+                            auto z = y;
+                            y = z;
+                        }
+                    });
+
+                if (i % 2)
+                    x.reset ();
+
+                for (auto& t : v)
+                    t.join ();
+            }
+        }).join ();
+
+        BOOST_TEST (100 == counter);
+    }
+}
+
+} // namespace _16
+
+BOOST_AUTO_TEST_CASE (shared_resource_test) {
+    using namespace _16;
+
+    do_shared_resource_test< X::atomic_refcount > ();
+    do_shared_resource_test< X::biased_refcount > ();
+
+    static_assert (sizeof (X::shared_resource< int, fd_delete >) == sizeof (void*));
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _17 {
+
+//
+// Released payloads are kept, marked dead, so that readers can check:
+//
+struct payload {
+    std::atomic< bool > dead{ false };
+};
+
+static std::atomic< int > counter /* = 0 */;
+
+struct payload_delete {
+    static constexpr payload* invalid_resource = nullptr;
+
+    void operator() (payload* p) const noexcept {
+        p->dead = true;
+        ++counter;
+    }
+};
+
+using resource_type = X::unique_resource< payload*, payload_delete >;
+
+} // namespace _17
+
+BOOST_AUTO_TEST_CASE (atomic_unique_resource_test) {
+    using namespace _17;
+
+    {
+        counter = 0;
+
+        payload a, b, c;
+
+        {
+            X::atomic_unique_resource< payload*, payload_delete > x (
+                resource_type (&a, payload_delete { }));
+
+            {
+                auto g = x.load ();
+                BOOST_TEST (&a == g.get ());
+
+                x.store (resource_type (&b, payload_delete { }));
+                BOOST_TEST (&b == x.load ().get ());
+
+                //
+                // Still protected by g:
+                //
+                BOOST_TEST (false == a.dead);
+                BOOST_TEST (1U == x.retired ());
+            }
+
+            x.reclaim ();
+            BOOST_TEST (true == a.dead);
+            BOOST_TEST (0U == x.retired ());
+
+            payload* expected = &a;
+            resource_type r (&c, payload_delete { });
+
+            BOOST_TEST (false == x.compare_exchange (expected, r));
+            BOOST_TEST (&b == expected);
+            BOOST_TEST (&c == r.get ());
+
+            BOOST_TEST (true == x.compare_exchange (expected, r));
+            BOOST_TEST (true == b.dead);
+            BOOST_TEST (&c == x.load ().get ());
+
+            x.reset ();
+            BOOST_TEST (true == c.dead);
+            BOOST_TEST (nullptr == x.load ().get ());
+        }
+
+        BOOST_TEST (3 == counter);
+    }
+
+    {
+        counter = 0;
+
+        std::vector< payload > v (1000);
+
+        {
+            X::atomic_unique_resource< payload*, payload_delete > x (
+                resource_type (&v [0], payload_delete { }));
+
+            std::atomic< bool > done{ false };
+            std::atomic< int > errors{ 0 };
+
+            std::vector< std::thread > readers;
+
+            for (int j = 0; j < 4; ++j)
+                readers.emplace_back ([&] {
+                    while (!done) {
+                        auto g = x.load ();
+
+                        if (g->dead)
+                            ++errors;
+                    }
+                });
+
+            for (std::size_t i = 1; i < v.size (); ++i)
+                x.store (resource_type (&v [i], payload_delete { }));
+
+            done = true;
+
+            for (auto& t : readers)
+                t.join ();
+
+            BOOST_TEST (0 == errors);
+        }
+
+        BOOST_TEST (1000 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _18 {
+
+static std::atomic< int > counter /* = 0 */;
+
+//
+// Released tables are kept, marked dead, so that readers can check:
+//
+struct table {
+    std::atomic< bool > dead{ false };
+};
+
+struct table_delete {
+    void operator() (table* p) const noexcept {
+        p->dead = true;
+        ++counter;
+    }
+};
+
+using resource_type = X::unique_resource< table*, table_delete >;
+
+} // namespace _18
+
+BOOST_AUTO_TEST_CASE (rcu_resource_test) {
+    using namespace _18;
+
+    {
+        counter = 0;
+
+        table a, b;
+
+        {
+            X::rcu_resource< table*, table_delete > x (
+                resource_type (&a, table_delete { }));
+
+            BOOST_TEST (&a == x.read ([](table* p) { return p; }));
+
+            std::atomic< bool > stored{ false };
+            std::thread writer;
+
+            {
+                X::rcu_read_guard guard;
+
+                table* p = x.read (guard);
+                BOOST_TEST (&a == p);
+
+                writer = std::thread ([&] {
+                    x.store (resource_type (&b, table_delete { }));
+                    stored = true;
+                });
+
+                //
+                // The writer waits for the grace period:
+                //
+                std::this_thread::sleep_for (std::chrono::milliseconds (50));
+
+                BOOST_TEST (false == stored);
+                BOOST_TEST (false == p->dead);
+
+                {
+                    X::rcu_read_guard nested;
+                }
+
+                BOOST_TEST (false == a.dead);
+            }
+
+            writer.join ();
+
+            BOOST_TEST (true == a.dead);
+            BOOST_TEST (&b == x.read ([](table* p) { return p; }));
+        }
+
+        BOOST_TEST (2 == counter);
+    }
+
+    {
+        counter = 0;
+
+        std::vector< table > v (200);
+
+        {
+            X::rcu_resource< table*, table_delete > x (
+                resource_type (&v [0], table_delete { }));
+
+            std::atomic< bool > done{ false };
+            std::atomic< int > errors{ 0 };
+
+            std::vector< std::thread > readers;
+
+            for (int j = 0; j < 4; ++j)
+                readers.emplace_back ([&] {
+                    while (!done) {
+                        X::rcu_read_guard guard;
+
+                        if (x.read (guard)->dead)
+                            ++errors;
+                    }
+                });
+
+            for (std::size_t i = 1; i < v.size (); ++i)
+                x.store (resource_type (&v [i], table_delete { }));
+
+            done = true;
+
+            for (auto& t : readers)
+                t.join ();
+
+            BOOST_TEST (0 == errors);
+        }
+
+        BOOST_TEST (200 == counter);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _19 {
+
+static std::vector< int > released;
+
+struct deleter {
+    void operator() (int i) const noexcept {
+        released.push_back (i);
+    }
+};
+
+struct throwing_deleter {
+    throwing_deleter () = default;
+    throwing_deleter (const throwing_deleter&) { throw 1; }
+
+    void operator() (int i) const noexcept {
+        released.push_back (i);
+    }
+};
+
+//
+// Over-aligned, to exercise the bump allocator:
+//
+struct alignas (64) big {
+    bool operator!= (const big& other) const noexcept {
+        return value != other.value;
+    }
+
+    int value;
+};
+
+struct big_deleter {
+    void operator() (const big& x) const noexcept {
+        BOOST_TEST (0U == reinterpret_cast< std::uintptr_t > (&x) % 64);
+        released.push_back (x.value);
+    }
+};
+
+} // namespace _19
+
+BOOST_AUTO_TEST_CASE (resource_arena_test) {
+    using namespace _19;
+
+    {
+        released.clear ();
+
+        {
+            X::resource_arena arena (64);
+
+            for (int i = 0; i < 100; ++i) {
+                auto& r = arena.emplace (i, deleter { });
+                BOOST_TEST (i == r.get ());
+            }
+
+            BOOST_TEST (100U == arena.size ());
+
+            arena.clear ();
+
+            BOOST_TEST (0U == arena.size ());
+            BOOST_TEST (100U == released.size ());
+
+            for (int i = 0; i < 100; ++i)
+                BOOST_TEST (99 - i == released [i]);
+
+            released.clear ();
+
+            arena.emplace (1, deleter { });
+            arena.emplace (2, deleter { }).release ();
+            arena.emplace_checked (-1, -1, deleter { });
+            arena.emplace_checked (3, -1, deleter { });
+            arena.adopt (X::make_unique_resource (4, deleter { }));
+            arena.emplace (big { 5 }, big_deleter { });
+        }
+
+        BOOST_TEST ((std::vector< int > { 5, 4, 3, 1 }) == released);
+    }
+
+    {
+        released.clear ();
+
+        X::resource_arena arena;
+
+        BOOST_CHECK_THROW (arena.emplace (1, throwing_deleter { }), int);
+        BOOST_TEST ((std::vector< int > { 1 }) == released);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _20 {
+
+static std::vector< int > calls;
+
+template< typename T >
+void do_defer_stack_test (bool fail, std::vector< int > expected) {
+    calls.clear ();
+
+    try {
+        T d;
+
+        for (int i = 0; i < 4; ++i)
+            d.defer ([i] { calls.push_back (i); });
+
+        //
+        // Past the inline buffer:
+        //
+        std::array< char, 64 > big { };
+        d += [big] { calls.push_back (int (big.size ())); };
+
+        BOOST_TEST (5U == d.size ());
+
+        if (fail)
+            throw 1;
+    }
+    catch (int) { }
+
+    BOOST_TEST (expected == calls);
+}
+
+struct throwing_callable {
+    throwing_callable () = default;
+    throwing_callable (const throwing_callable&) { throw 1; }
+
+    void operator() () const noexcept {
+        calls.push_back (-1);
+    }
+};
+
+} // namespace _20
+
+BOOST_AUTO_TEST_CASE (defer_stack_test) {
+    using namespace _20;
+
+    const std::vector< int > all { 64, 3, 2, 1, 0 }, none { };
+
+    do_defer_stack_test< X::defer_exit_stack< 64 > > (false, all);
+    do_defer_stack_test< X::defer_exit_stack< 64 > > (true, all);
+    do_defer_stack_test< X::defer_fail_stack< 64 > > (false, none);
+    do_defer_stack_test< X::defer_fail_stack< 64 > > (true, all);
+    do_defer_stack_test< X::defer_success_stack< 64 > > (false, all);
+    do_defer_stack_test< X::defer_success_stack< 64 > > (true, none);
+
+    {
+        calls.clear ();
+
+        {
+            X::defer_stack< > d;
+            d.defer ([] { calls.push_back (1); });
+            d.release ();
+        }
+
+        BOOST_TEST (calls.empty ());
+    }
+
+    {
+        calls.clear ();
+
+        {
+            X::defer_stack< > d;
+            throwing_callable f;
+
+            BOOST_CHECK_THROW (d.defer (f), int);
+            BOOST_TEST (0U == d.size ());
+        }
+
+        BOOST_TEST ((std::vector< int > { -1 }) == calls);
+    }
+
+    //
+    // Out of memory past the inline buffer, f runs only if the stack would
+    // run it:
+    //
+    auto push_past_buffer = [](auto& d, int i) {
+        std::array< char, 64 > big { };
+
+        fail_next_allocation = true;
+
+        BOOST_CHECK_THROW (
+            d.defer ([big, i] { (void) big; calls.push_back (i); }),
+            std::bad_alloc);
+
+        BOOST_TEST (!fail_next_allocation);
+        BOOST_TEST (0U == d.size ());
+    };
+
+    {
+        calls.clear ();
+
+        X::defer_exit_stack< 16 > a;
+        push_past_buffer (a, 1);
+
+        X::defer_fail_stack< 16 > b;
+        push_past_buffer (b, 2);
+
+        X::defer_success_stack< 16 > c;
+        push_past_buffer (c, 3);
+
+        X::defer_exit_stack< 16 > d;
+        d.release ();
+        push_past_buffer (d, 4);
+
+        BOOST_TEST ((std::vector< int > { 1, 2 }) == calls);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _21 {
+
+static std::vector< int > calls;
+
+template< typename T >
+void do_transaction_test (T& t, bool fail) {
+    auto a = X::make_scope_fail (t, [] { calls.push_back (1); });
+    auto b = X::make_scope_success (t, [] { calls.push_back (2); });
+
+    if (fail)
+        throw 1;
+}
+
+} // namespace _21
+
+BOOST_AUTO_TEST_CASE (transaction_test) {
+    using namespace _21;
+
+    {
+        X::transaction_scope t;
+
+        calls.clear ();
+        do_transaction_test (t, false);
+        BOOST_TEST ((std::vector< int > { 2 }) == calls);
+
+        calls.clear ();
+        BOOST_CHECK_THROW (do_transaction_test (t, true), int);
+        BOOST_TEST ((std::vector< int > { 1 }) == calls);
+
+        calls.clear ();
+
+        {
+            auto a = X::make_scope_fail (t, [] { calls.push_back (1); });
+            auto b = X::make_scope_success (t, [] { calls.push_back (2); });
+
+            a.release ();
+            b.release ();
+        }
+
+        BOOST_TEST (calls.empty ());
+    }
+
+    {
+        X::transaction t;
+
+        calls.clear ();
+        BOOST_CHECK_THROW (do_transaction_test (t, true), int);
+        BOOST_TEST ((std::vector< int > { 1 }) == calls);
+
+        //
+        // Not committed, although no exception is thrown:
+        //
+        calls.clear ();
+        do_transaction_test (t, false);
+        BOOST_TEST ((std::vector< int > { 1 }) == calls);
+
+        calls.clear ();
+
+        {
+            auto a = X::make_scope_fail (t, [] { calls.push_back (1); });
+            auto b = X::make_scope_success (t, [] { calls.push_back (2); });
+
+            t.commit ();
+        }
+
+        BOOST_TEST ((std::vector< int > { 2 }) == calls);
+
+        calls.clear ();
+
+        {
+            auto a = X::make_scope_fail (t, [] { calls.push_back (1); });
+
+            t.rollback ();
+        }
+
+        BOOST_TEST ((std::vector< int > { 1 }) == calls);
+    }
+}
+
+namespace _22 {
+
+static std::vector< int > calls;
+
+struct deleter {
+    void operator() (int i) const noexcept {
+        calls.push_back (id * 10 + i);
+    }
+
+    int id;
+};
+
+struct sentinel_deleter {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+} // namespace _22
+
+BOOST_AUTO_TEST_CASE (swap_test) {
+    using namespace _22;
+
+    static_assert (noexcept (
+        swap (std::declval< X::unique_resource< int, deleter >& > (),
+              std::declval< X::unique_resource< int, deleter >& > ())));
+
+    calls.clear ();
+
+    {
+        X::unique_resource< int, deleter > a (1, deleter { 1 });
+        X::unique_resource< int, deleter > b (2, deleter { 2 });
+
+        b.release ();
+        swap (a, b);
+
+        BOOST_TEST (2 == a.get ());
+        BOOST_TEST (1 == b.get ());
+        BOOST_TEST (2 == a.get_deleter ().id);
+        BOOST_TEST (1 == b.get_deleter ().id);
+
+        a.swap (b);
+        BOOST_TEST (1 == a.get ());
+    }
+
+    //
+    // Only the resource that was not released, with its own deleter:
+    //
+    BOOST_TEST ((std::vector< int > { 11 }) == calls);
+
+    calls.clear ();
+
+    {
+        X::unique_resource< int, sentinel_deleter > a (1, sentinel_deleter { });
+        X::unique_resource< int, sentinel_deleter > b (2, sentinel_deleter { });
+
+        b.release ();
+        swap (a, b);
+
+        BOOST_TEST (-1 == a.get ());
+        BOOST_TEST (1 == b.get ());
+
+        auto c = std::move (b);
+        BOOST_TEST (1 == c.get ());
+        BOOST_TEST (-1 == b.get ());
+    }
+
+    BOOST_TEST ((std::vector< int > { 1 }) == calls);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _23 {
+
+static std::vector< int > calls;
+
+struct skipped_deleter {
+    static constexpr bool skip_at_teardown = true;
+
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+struct sentinel_deleter : skipped_deleter {
+    static constexpr int invalid_resource = -1;
+};
+
+struct deleter {
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+} // namespace _23
+
+//
+// Irreversible, the last test to use skippable deleters:
+//
+BOOST_AUTO_TEST_CASE (teardown_test) {
+    using namespace _23;
+
+    static_assert (X::teardown_traits< skipped_deleter >::value);
+    static_assert (X::teardown_traits< skipped_deleter& >::value);
+    static_assert (!X::teardown_traits< deleter >::value);
+
+    calls.clear ();
+
+    {
+        auto a = X::make_unique_resource (1, skipped_deleter { });
+        auto b = X::make_scope_exit (X::skipped_at_teardown ([] { calls.push_back (2); }));
+    }
+
+    BOOST_TEST ((std::vector< int > { 2, 1 }) == calls);
+
+    calls.clear ();
+
+    {
+        auto a = X::make_unique_resource (1, skipped_deleter { });
+        auto b = X::make_unique_resource (2, deleter { });
+        auto c = X::make_unique_resource (3, sentinel_deleter { });
+        auto d = X::make_unique_resource (4, skipped_deleter { });
+
+        auto e = X::make_scope_exit (X::skipped_at_teardown ([] { calls.push_back (5); }));
+        auto f = X::make_scope_exit (X::kept_at_teardown ([] { calls.push_back (6); }));
+        auto g = X::make_scope_exit ([] { calls.push_back (7); });
+
+        X::begin_process_teardown ();
+        BOOST_TEST (X::in_process_teardown ());
+
+        //
+        // An explicit reset still runs the deleter:
+        //
+        d.reset ();
+    }
+
+    BOOST_TEST ((std::vector< int > { 4, 7, 6, 2 }) == calls);
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _24 {
+
+static std::vector< std::vector< int > > batches;
+
+struct bulk_delete {
+    void operator() (int i) const noexcept {
+        batches.push_back ({ i });
+    }
+
+    void operator() (const int* first, std::size_t n) const noexcept {
+        batches.emplace_back (first, first + n);
+    }
+};
+
+//
+// Fails on negative values:
+//
+int acquire (int i) noexcept {
+    return i < 0 ? -1 : i * 10;
+}
+
+//
+// A thread per task, joined on destruction:
+//
+struct thread_executor {
+    template< typename F >
+    void submit (F f) {
+        threads.emplace_back (std::move (f));
+    }
+
+    ~thread_executor () {
+        for (auto& t : threads)
+            t.join ();
+    }
+
+    std::vector< std::thread > threads;
+};
+
+struct inline_executor {
+    template< typename F >
+    void submit (F f) {
+        f ();
+    }
+};
+
+} // namespace _24
+
+BOOST_AUTO_TEST_CASE (bulk_acquisition_test) {
+    using namespace _24;
+
+    const std::vector< int > good { 1, 2, 3, 4 }, bad { 1, 2, -3, 4 };
+
+    batches.clear ();
+
+    {
+        auto v = X::make_unique_resources_checked (good, &acquire, -1, bulk_delete { });
+
+        BOOST_TEST (4U == v.size ());
+        BOOST_TEST ((std::vector< int > { 10, 20, 30, 40 }) ==
+                    std::vector< int > (v.begin (), v.end ()));
+        BOOST_TEST (batches.empty ());
+    }
+
+    BOOST_TEST (1U == batches.size ());
+
+    batches.clear ();
+
+    {
+        //
+        // Stops at the first failure, releasing the others in one batch:
+        //
+        int n = 0;
+
+        auto v = X::make_unique_resources_checked (
+            bad, [&](int i) { ++n; return acquire (i); }, -1, bulk_delete { });
+
+        BOOST_TEST (v.empty ());
+        BOOST_TEST (3 == n);
+        BOOST_TEST ((std::vector< std::vector< int > > { { 10, 20 } }) == batches);
+    }
+
+    batches.clear ();
+
+    BOOST_CHECK_THROW (
+        X::make_unique_resources_checked (
+            good, [](int i) {
+                if (3 == i)
+                    throw std::runtime_error ("3");
+                return acquire (i);
+            },
+            -1, bulk_delete { }),
+        std::runtime_error);
+
+    BOOST_TEST ((std::vector< std::vector< int > > { { 10, 20 } }) == batches);
+
+    //
+    // On an executor, the results are in order:
+    //
+    batches.clear ();
+
+    {
+        thread_executor e;
+
+        auto v = X::make_unique_resources_checked (
+            e, good, &acquire, -1, bulk_delete { });
+
+        BOOST_TEST ((std::vector< int > { 10, 20, 30, 40 }) ==
+                    std::vector< int > (v.begin (), v.end ()));
+    }
+
+    BOOST_TEST (1U == batches.size ());
+
+    batches.clear ();
+
+    {
+        thread_executor e;
+
+        auto v = X::make_unique_resources_checked (
+            e, bad, &acquire, -1, bulk_delete { });
+
+        BOOST_TEST (v.empty ());
+        BOOST_TEST (1U == batches.size ());
+    }
+
+    batches.clear ();
+
+    {
+        //
+        // Inline, those after the failure are skipped:
+        //
+        inline_executor e;
+        int n = 0;
+
+        auto v = X::make_unique_resources_checked (
+            e, bad, [&](int i) { ++n; return acquire (i); }, -1, bulk_delete { });
+
+        BOOST_TEST (v.empty ());
+        BOOST_TEST (3 == n);
+        BOOST_TEST ((std::vector< std::vector< int > > { { 10, 20 } }) == batches);
+    }
+
+    batches.clear ();
+
+    {
+        X::reaper r;
+
+        BOOST_CHECK_THROW (
+            X::make_unique_resources_checked (
+                r, good, [](int i) {
+                    if (2 == i)
+                        throw std::runtime_error ("2");
+                    return acquire (i);
+                },
+                -1, bulk_delete { }),
+            std::runtime_error);
+
+        BOOST_TEST ((std::vector< std::vector< int > > { { 10 } }) == batches);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+
+namespace _25 {
+
+static std::vector< int > calls;
+
+struct deleter {
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+struct pointer_deleter {
+    void operator() (int* p) const noexcept {
+        calls.push_back (*p);
+    }
+};
+
+using T = X::unique_resources<
+    std::pair< int, deleter >,
+    std::pair< int*, pointer_deleter >,
+    std::pair< int, deleter > >;
+
+//
+// One ownership byte for all, instead of a flag and its padding for each:
+//
+static_assert (sizeof (T) < sizeof (X::unique_resource< int, deleter >) * 2 +
+               sizeof (X::unique_resource< int*, pointer_deleter >));
+
+static_assert (sizeof (T) == 3 * sizeof (int*));
+
+} // namespace _25
+
+BOOST_AUTO_TEST_CASE (unique_resources_test) {
+    using namespace _25;
+
+    int two = 2;
+
+    calls.clear ();
+
+    {
+        T x ({ 1, deleter { } }, { &two, pointer_deleter { } }, { 3, deleter { } });
+
+        BOOST_TEST (x.owns< 0 > ());
+        BOOST_TEST (x.owns< 1 > ());
+        BOOST_TEST (x.owns< 2 > ());
+
+        BOOST_TEST (1 == x.get< 0 > ());
+        BOOST_TEST (&two == x.get< 1 > ());
+        BOOST_TEST (3 == x.get< 2 > ());
+    }
+
+    //
+    // Last to first:
+    //
+    BOOST_TEST ((std::vector< int > { 3, 2, 1 }) == calls);
+
+    calls.clear ();
+
+    {
+        T x;
+
+        BOOST_TEST (!x.owns< 0 > ());
+        BOOST_TEST (!x.owns< 1 > ());
+        BOOST_TEST (!x.owns< 2 > ());
+
+        //
+        // Acquired one by one:
+        //
+        x.reset< 0 > (1);
+        x.reset< 2 > (3);
+
+        BOOST_TEST (!x.owns< 1 > ());
+
+        x.reset< 0 > (4);
+        BOOST_TEST ((std::vector< int > { 1 }) == calls);
+
+        BOOST_TEST (3 == x.release< 2 > ());
+        BOOST_TEST (!x.owns< 2 > ());
+
+        T y (std::move (x));
+
+        BOOST_TEST (!x.owns< 0 > ());
+        BOOST_TEST (y.owns< 0 > ());
+        BOOST_TEST (4 == y.get< 0 > ());
+
+        x.reset< 1 > (&two);
+        swap (x, y);
+
+        BOOST_TEST (y.owns< 1 > ());
+        BOOST_TEST (!y.owns< 0 > ());
+        BOOST_TEST (x.owns< 0 > ());
+
+        y = std::move (x);
+        BOOST_TEST ((std::vector< int > { 1, 2 }) == calls);
+
+        y.reset< 0 > ();
+        BOOST_TEST ((std::vector< int > { 1, 2, 4 }) == calls);
+    }
+
+    BOOST_TEST ((std::vector< int > { 1, 2, 4 }) == calls);
+
+    calls.clear ();
+
+    {
+        T x ({ 1, deleter { } }, { &two, pointer_deleter { } }, { 3, deleter { } });
+
+        x.release_all ();
+    }
+
+    BOOST_TEST (calls.empty ());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
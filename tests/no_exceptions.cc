@@ -0,0 +1,205 @@
+// -*- mode: c++ -*-
+
+//
+// Built twice, with and without -fno-exceptions (see Makefile.am), without
+// Boost.Test which needs exceptions. Exits with the number of failed checks.
+//
+
+#include <unique_resource.hh>
+#include <defer_stack.hh>
+#include <relocate.hh>
+#include <resource_arena.hh>
+#include <resource_pool.hh>
+
+#include <iostream>
+#include <vector>
+
+namespace X = std::experimental;
+
+static int failures /* = 0 */;
+
+#define CHECK(x)                                                        \
+    do {                                                                \
+        if (!(x)) {                                                     \
+            std::cerr << __FILE__ << "(" << __LINE__ << "): check "     \
+                      << #x << " has failed\n";                         \
+            ++failures;                                                 \
+        }                                                               \
+    } while (0)
+
+////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+std::vector< int > calls;
+
+struct deleter {
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+//
+// Neither nothrow move assignable nor move-only, assignment takes the
+// copying path that catches exceptions when they are enabled:
+//
+struct copying_deleter {
+    copying_deleter () = default;
+    copying_deleter (const copying_deleter&) = default;
+    copying_deleter& operator= (const copying_deleter&) noexcept (false) {
+        return *this;
+    }
+
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+struct copying_resource {
+    copying_resource (int i) noexcept : value (i) { }
+
+    copying_resource (const copying_resource&) = default;
+    copying_resource& operator= (const copying_resource&) noexcept (false) = default;
+
+    operator int () const noexcept {
+        return value;
+    }
+
+    int value;
+};
+
+struct factory {
+    int operator() () const {
+        return 7;
+    }
+};
+
+void unique_resource_test () {
+    calls.clear ();
+
+    {
+        auto a = X::make_unique_resource (1, deleter { });
+        auto b = X::make_unique_resource (2, deleter { });
+
+        a = std::move (b);
+        CHECK ((std::vector< int > { 1 }) == calls);
+    }
+
+    CHECK ((std::vector< int > { 1, 2 }) == calls);
+
+    calls.clear ();
+
+    {
+        using T = X::unique_resource< copying_resource, copying_deleter >;
+
+        T a (copying_resource (1), copying_deleter { });
+        T b (copying_resource (2), copying_deleter { });
+
+        a = std::move (b);
+        CHECK ((std::vector< int > { 1 }) == calls);
+    }
+
+    CHECK ((std::vector< int > { 1, 2 }) == calls);
+}
+
+void scope_guard_test () {
+    calls.clear ();
+
+    {
+        auto a = X::make_scope_exit ([] { calls.push_back (1); });
+        auto b = X::make_scope_fail ([] { calls.push_back (2); });
+        auto c = X::make_scope_success ([] { calls.push_back (3); });
+
+#if defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+        //
+        // Committed explicitly:
+        //
+        b.release ();
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+    }
+
+    CHECK ((std::vector< int > { 3, 1 }) == calls);
+
+    calls.clear ();
+
+    {
+        //
+        // Not committed, e.g., an early error return:
+        //
+        auto b = X::make_scope_fail ([] { calls.push_back (2); });
+    }
+
+#if defined (UNIQUE_RESOURCE_NO_EXCEPTIONS)
+    CHECK ((std::vector< int > { 2 }) == calls);
+#else
+    CHECK (calls.empty ());
+#endif // UNIQUE_RESOURCE_NO_EXCEPTIONS
+
+    calls.clear ();
+
+    {
+        X::transaction t;
+
+        auto a = X::make_scope_fail (t, [] { calls.push_back (1); });
+        auto b = X::make_scope_success (t, [] { calls.push_back (2); });
+
+        t.commit ();
+    }
+
+    CHECK ((std::vector< int > { 2 }) == calls);
+
+    calls.clear ();
+
+    {
+        X::defer_exit_stack< > d;
+
+        d.defer ([] { calls.push_back (1); });
+        d.defer ([] { calls.push_back (2); });
+    }
+
+    CHECK ((std::vector< int > { 2, 1 }) == calls);
+}
+
+void containers_test () {
+    calls.clear ();
+
+    {
+        X::relocating_vector< X::unique_resource< int, deleter > > v;
+
+        for (int i = 0; i < 4; ++i)
+            v.emplace_back (i, deleter { });
+    }
+
+    CHECK (4U == calls.size ());
+
+    calls.clear ();
+
+    {
+        X::resource_arena arena;
+
+        arena.emplace (1, deleter { });
+        arena.emplace_checked (2, 2, deleter { });
+        arena.emplace (3, deleter { });
+    }
+
+    CHECK ((std::vector< int > { 3, 1 }) == calls);
+
+    calls.clear ();
+
+    {
+        X::resource_pool< int, factory, deleter > pool;
+        CHECK (7 == pool.acquire ().get ());
+    }
+
+    CHECK ((std::vector< int > { 7 }) == calls);
+}
+
+} // namespace
+
+int main () {
+    unique_resource_test ();
+    scope_guard_test ();
+    containers_test ();
+
+    return failures;
+}
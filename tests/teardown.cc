@@ -0,0 +1,90 @@
+// -*- mode: c++ -*-
+
+//
+// Built with UNIQUE_RESOURCE_FAST_SHUTDOWN defined (see Makefile.am), every
+// deleter skippable at teardown unless allow-listed. Without Boost.Test, the
+// teardown is irreversible. Exits with the number of failed checks.
+//
+
+#include <unique_resource.hh>
+
+#include <iostream>
+#include <vector>
+
+namespace X = std::experimental;
+
+static int failures /* = 0 */;
+
+#define CHECK(x)                                                        \
+    do {                                                                \
+        if (!(x)) {                                                     \
+            std::cerr << __FILE__ << "(" << __LINE__ << "): check "     \
+                      << #x << " has failed\n";                         \
+            ++failures;                                                 \
+        }                                                               \
+    } while (0)
+
+////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+std::vector< int > calls;
+
+struct deleter {
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+//
+// E.g., a file to flush:
+//
+struct kept_deleter {
+    static constexpr bool skip_at_teardown = false;
+
+    void operator() (int i) const noexcept {
+        calls.push_back (i);
+    }
+};
+
+void record (int i) noexcept {
+    calls.push_back (i);
+}
+
+} // namespace
+
+int main () {
+    static_assert (X::teardown_traits< deleter >::value);
+    static_assert (X::teardown_traits< void(*)(int) >::value);
+    static_assert (!X::teardown_traits< kept_deleter >::value);
+
+    {
+        auto a = X::make_unique_resource (1, deleter { });
+        auto b = X::make_unique_resource (2, &record);
+        auto c = X::make_scope_exit ([] { calls.push_back (3); });
+    }
+
+    CHECK ((std::vector< int > { 3, 2, 1 }) == calls);
+
+    calls.clear ();
+
+    {
+        auto a = X::make_unique_resource (1, deleter { });
+        auto b = X::make_unique_resource (2, kept_deleter { });
+        auto c = X::make_unique_resource (3, X::kept_at_teardown (&record));
+
+        auto d = X::make_scope_exit ([] { calls.push_back (4); });
+        auto e = X::make_scope_exit (X::kept_at_teardown ([] { calls.push_back (5); }));
+
+        //
+        // Not a scope_exit:
+        //
+        auto f = X::make_scope_success ([] { calls.push_back (6); });
+
+        X::begin_process_teardown ();
+    }
+
+    CHECK ((std::vector< int > { 6, 5, 3, 2 }) == calls);
+
+    return failures;
+}
@@ -0,0 +1,128 @@
+// -*- mode: c++ -*-
+
+//
+// Built with UNIQUE_RESOURCE_TRACKING defined, every acquisition tracked in
+// a table of 16 records (see Makefile.am):
+//
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE tracking
+
+#include <unique_resource.hh>
+#include <resource_tracker.hh>
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace X = std::experimental;
+
+namespace {
+
+struct tracked_delete {
+    void operator() (int) const noexcept { }
+};
+
+struct guard_function {
+    void operator() () const noexcept { }
+};
+
+using resource = X::unique_resource< int, tracked_delete >;
+
+std::string dump () {
+    std::ostringstream s;
+    X::resource_tracker::instance ().dump (s);
+
+    return s.str ();
+}
+
+//
+// The first line of the dump:
+//
+std::string summary () {
+    const auto s = dump ();
+    return s.substr (0, s.find ('\n'));
+}
+
+__attribute__ ((noinline)) resource acquire_here (int i) {
+    return X::make_unique_resource (int (i), tracked_delete { });
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(tracking)
+
+BOOST_AUTO_TEST_CASE (live_test) {
+    BOOST_TEST (0U == summary ().find ("resource_tracker: 0 live, 0 leaked"));
+
+    {
+        std::vector< resource > v;
+
+        for (int i = 0; i < 2; ++i)
+            v.push_back (acquire_here (i));
+
+        //
+        // Moves and swaps carry the record along:
+        //
+        auto b = std::move (v [0]);
+        auto c = std::move (v [1]);
+
+        swap (b, c);
+
+        BOOST_TEST (0U == summary ().find ("resource_tracker: 2 live, 0 leaked"));
+
+        const auto s = dump ();
+
+        //
+        // Both from the same stack, one group:
+        //
+        BOOST_TEST (std::string::npos != s.find ("#0: 2 live, 0 leaked"));
+        BOOST_TEST (std::string::npos == s.find ("#1:"));
+        BOOST_TEST (std::string::npos != s.find ("unique_resource<int"));
+        BOOST_TEST (std::string::npos != s.find ("tracked_delete"));
+
+        c.reset ();
+        BOOST_TEST (0U == summary ().find ("resource_tracker: 1 live, 0 leaked"));
+    }
+
+    BOOST_TEST (0U == summary ().find ("resource_tracker: 0 live, 0 leaked"));
+}
+
+BOOST_AUTO_TEST_CASE (leak_test) {
+    {
+        auto a = acquire_here (1);
+        auto g = X::make_scope_exit (guard_function { });
+
+        a.release ();
+
+        const auto s = dump ();
+
+        BOOST_TEST (0U == s.find ("resource_tracker: 1 live, 1 leaked"));
+        BOOST_TEST (std::string::npos != s.find ("guard_function"));
+    }
+
+    BOOST_TEST (0U == summary ().find ("resource_tracker: 0 live, 1 leaked"));
+}
+
+//
+// Live records are not overwritten, acquisitions beyond them are dropped:
+//
+BOOST_AUTO_TEST_CASE (capacity_test) {
+    {
+        std::vector< resource > v;
+
+        for (int i = 0; i < 20; ++i)
+            v.push_back (acquire_here (i));
+
+        const auto s = summary ();
+
+        BOOST_TEST (0U == s.find ("resource_tracker: 16 live, 0 leaked"));
+        BOOST_TEST (std::string::npos != s.find ("4 dropped"));
+    }
+
+    BOOST_TEST (0U == summary ().find ("resource_tracker: 0 live"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
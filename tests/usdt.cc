@@ -0,0 +1,47 @@
+// -*- mode: c++ -*-
+
+//
+// Built with UNIQUE_RESOURCE_USDT defined when sys/sdt.h is available (see
+// Makefile.am); usdt.sh looks for the probes in its ELF notes. Every probe
+// site is instantiated here.
+//
+
+#include <unique_resource.hh>
+
+namespace X = std::experimental;
+
+static int counter /* = 0 */;
+
+struct flag_delete {
+    void operator() (int i) const noexcept {
+        counter += i;
+    }
+};
+
+struct sentinel_delete {
+    static constexpr int invalid_resource = -1;
+
+    void operator() (int i) const noexcept {
+        counter += i;
+    }
+};
+
+int main () {
+    {
+        auto a = X::make_unique_resource (1, flag_delete { });
+        auto b = X::make_unique_resource_checked (2, -1, flag_delete { });
+
+        b.release ();
+        a.reset (3);
+        a.reset ();
+    }
+
+    {
+        X::unique_resource< int, sentinel_delete > a (4, sentinel_delete { });
+
+        auto g = X::make_scope_exit ([] { ++counter; });
+        auto h = X::make_scope_fail ([] { ++counter; });
+    }
+
+    return 9 == counter ? 0 : 1;
+}
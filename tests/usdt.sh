@@ -0,0 +1,34 @@
+#!/bin/sh
+#
+# Checks that the usdt program has every unique_resource probe in its ELF
+# notes. Skipped (exit 77) when it was not built, without sys/sdt.h, or
+# without readelf.
+#
+
+READELF=${READELF:-readelf}
+
+PROBES="acquire reset_value release destroy delete_begin delete_end
+        guard_begin guard_end"
+
+test -x ./usdt || exit 77
+command -v "$READELF" >/dev/null 2>&1 || exit 77
+
+./usdt || exit 1
+
+notes=`"$READELF" -n ./usdt | awk '
+    /Provider: unique_resource$/ { provider = 1; next }
+    provider && /Name:/          { print $2 }
+                                 { provider = 0 }'`
+
+failures=0
+
+for p in $PROBES; do
+    if echo "$notes" | grep -qx "$p"; then
+        echo "found: $p"
+    else
+        echo "FAIL: $p"
+        failures=`expr $failures + 1`
+    fi
+done
+
+test 0 -eq $failures